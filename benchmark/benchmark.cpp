@@ -0,0 +1,532 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "korean_romanizer.h"
+#include "test/reference_romanizer.h"
+
+/**
+ * The amount of allocations made through the global <code>operator new</code> since the program started.
+ */
+std::atomic<std::size_t> allocation_count{0};
+
+/**
+ * Counts and makes an allocation for every form of the global <code>operator new</code>,
+ * kept out of line so that the compiler pairs it with <code>release</code> instead of with the <code>operator delete</code> it replaces.
+ *
+ * @return The allocation, or null if it failed.
+ */
+[[gnu::noinline]] void* allocate(const std::size_t size, const std::size_t alignment) noexcept {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (alignment <= alignof(std::max_align_t))
+        return std::malloc(size ? size : 1);
+    // aligned_alloc needs a size that is a multiple of the alignment
+    return std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment);
+}
+
+/**
+ * Frees an allocation made by <code>allocate</code> for every form of the global <code>operator delete</code>.
+ */
+[[gnu::noinline]] void release(void* const p) noexcept { std::free(p); }
+
+void* operator new(const std::size_t size) {
+    if (void* const p = allocate(size, alignof(std::max_align_t)))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](const std::size_t size) { return operator new(size); }
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+    if (void* const p = allocate(size, static_cast<std::size_t>(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](const std::size_t size, const std::align_val_t alignment) { return operator new(size, alignment); }
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* const p) noexcept { release(p); }
+void operator delete[](void* const p) noexcept { release(p); }
+void operator delete(void* const p, std::size_t) noexcept { release(p); }
+void operator delete[](void* const p, std::size_t) noexcept { release(p); }
+void operator delete(void* const p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* const p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* const p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* const p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete(void* const p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* const p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete(void* const p, std::align_val_t, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* const p, std::align_val_t, const std::nothrow_t&) noexcept { release(p); }
+
+/**
+ * Encodes a sequence of code points as UTF-8.
+ */
+std::string to_utf8(const std::u32string& w) {
+    std::string s;
+    for (const char32_t c : w) {
+        if (c < 0x80)
+            s += static_cast<char>(c);
+        else if (c < 0x800)
+            s += {static_cast<char>(0xC0 | c >> 6), static_cast<char>(0x80 | (c & 0x3F))};
+        else if (c < 0x10000)
+            s += {static_cast<char>(0xE0 | c >> 12), static_cast<char>(0x80 | (c >> 6 & 0x3F)), static_cast<char>(0x80 | (c & 0x3F))};
+        else
+            s += {static_cast<char>(0xF0 | c >> 18), static_cast<char>(0x80 | (c >> 12 & 0x3F)), static_cast<char>(0x80 | (c >> 6 & 0x3F)), static_cast<char>(0x80 | (c & 0x3F))};
+    }
+    return s;
+}
+
+/**
+ * Decomposes every Hangul character of a string into conjoining jamo, as in NFD.
+ */
+std::u32string decompose(const std::u32string& w) {
+    std::u32string decomposed;
+    for (const char32_t c : w) {
+        if (c < 0xAC00 || c > 0xD7A3) {
+            decomposed += c;
+            continue;
+        }
+        const char32_t index = c - 0xAC00;
+        decomposed += {static_cast<char32_t>(0x1100 + index / 588), static_cast<char32_t>(0x1161 + index / 28 % 21)};
+        if (index % 28)
+            decomposed += static_cast<char32_t>(0x11A7 + index % 28);
+    }
+    return decomposed;
+}
+
+/**
+ * @brief A set of strings to be romanized, generated from a fixed seed so that every run and every commit measures the same input.
+ */
+struct corpus {
+    std::string name;
+    /**
+     * The code points of every string, which the reference rules work on.
+     */
+    std::vector<std::u32string> code_points;
+    /**
+     * The UTF-8 encoding of every string, which the optimized paths work on.
+     */
+    std::vector<std::string> strings;
+    std::size_t bytes = 0;
+    std::size_t syllables = 0;
+
+    void add(std::u32string w) {
+        add(std::move(w), false);
+    }
+    /**
+     * Adds a string, encoding its Hangul characters as conjoining jamo as in NFD if requested,
+     * which the reference rules cannot read but which romanizes the same.
+     */
+    void add(std::u32string w, const bool decomposed) {
+        strings.push_back(to_utf8(decomposed ? decompose(w) : w));
+        bytes += strings.back().size();
+        syllables += std::count_if(w.begin(), w.end(), [](const char32_t c) { return c >= 0xAC00 && c <= 0xD7A3; });
+        code_points.push_back(std::move(w));
+    }
+};
+
+/**
+ * Generates text in which every character is a random Hangul syllable with the given probability, and otherwise drawn from the given other characters.
+ */
+std::u32string random_text(std::mt19937& random, const std::size_t length, const double hangul_probability, const std::u32string_view others) {
+    std::uniform_real_distribution<double> probability;
+    std::u32string w;
+    w.reserve(length);
+    while (w.size() < length)
+        w += probability(random) < hangul_probability ? static_cast<char32_t>(0xAC00 + random() % 11172) : others[random() % others.size()];
+    return w;
+}
+
+/**
+ * Generates the corpora, each of roughly the given size in bytes.
+ */
+std::vector<corpus> make_corpora(const std::size_t size) {
+    std::vector<corpus> corpora(7);
+    std::mt19937 random(20240201);
+    corpora[0].name = "hangul";
+    corpora[0].add(random_text(random, size / 3, 1, U""));
+    corpora[1].name = "hangul_mixed";
+    corpora[1].add(random_text(random, size / 3, 0.8, U"      .,?!0123456789()\"'-·「」\U0001F600"));
+    corpora[2].name = "mostly_ascii";
+    for (std::size_t bytes = 0; bytes < size;) {
+        // a JSON record with a short Korean name in it
+        std::u32string w = U"{\"id\": " + random_text(random, 6, 0, U"0123456789") + U", \"name\": \"";
+        w += random_text(random, 2 + random() % 3, 1, U"") + U"\", \"status\": \"active\", \"tags\": [\"user\", \"verified\"]}\n";
+        bytes += w.size();
+        corpora[2].code_points.push_back(std::move(w));
+    }
+    {
+        std::u32string w;
+        for (const std::u32string& record : corpora[2].code_points)
+            w += record;
+        corpora[2].code_points.clear();
+        corpora[2].add(std::move(w));
+    }
+    // the same names, once as many short strings and once as one huge string
+    corpora[3].name = "short_strings";
+    corpora[4].name = "short_strings_joined";
+    std::u32string joined;
+    while (corpora[3].bytes < size) {
+        std::u32string w = random_text(random, 2 + random() % 5, 1, U"");
+        joined += w + U'\n';
+        corpora[3].add(std::move(w));
+    }
+    corpora[4].add(std::move(joined));
+    // short strings drawn from a small vocabulary of names, with a few names much more common than the rest
+    corpora[5].name = "repeated_names";
+    std::vector<std::u32string> names(10000);
+    for (std::u32string& name : names)
+        name = random_text(random, 2 + random() % 3, 1, U"");
+    std::geometric_distribution<std::size_t> rank(0.001);
+    while (corpora[5].bytes < size)
+        corpora[5].add(names[rank(random) % names.size()] + U' ' + names[rank(random) % names.size()]);
+    // Hangul text in NFD, as in file names from macOS, whose syllables take 6 to 9 bytes
+    corpora[6].name = "hangul_nfd";
+    corpora[6].add(random_text(random, size / 8, 0.85, U" "), true);
+    return corpora;
+}
+
+/**
+ * @brief A way of romanizing a corpus that is measured and checked against the reference rules.
+ */
+struct path {
+    std::string name;
+    /**
+     * Romanizes every string of the corpus, appending each romanization to the result if it is not null.
+     */
+    void (*romanize)(const corpus& c, std::vector<std::string>* result);
+    /**
+     * The amount of calls the path makes per run over a corpus.
+     */
+    std::size_t (*calls)(const corpus& c);
+    /**
+     * The path this one adds a feature to and is compared against, such as <code>romanize_append</code>, or null.
+     */
+    const char* baseline = nullptr;
+};
+
+std::size_t calls_per_string(const corpus& c) { return c.strings.size(); }
+
+std::size_t one_call(const corpus&) { return 1; }
+
+/**
+ * Builds a dictionary of a million random words on first use, romanized as the pronunciation rules romanize them, so that
+ * romanizing with it must produce the same romanizations as without it. Every word ends in a Hangul character without
+ * a trailing consonant, after which the next character is romanized the same whether it starts a word or not.
+ */
+const korean_romanizer_dictionary& large_dictionary() {
+    static const korean_romanizer_dictionary dictionary = [] {
+        std::mt19937 random(20240301);
+        std::vector<std::string> words(1000000), romanizations(words.size());
+        std::vector<std::pair<std::string_view, std::string_view>> pairs(words.size());
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            std::u32string w = random_text(random, 1 + random() % 3, 1, U"");
+            w += static_cast<char32_t>(0xAC00 + random() % 399 * 28);
+            words[i] = to_utf8(w);
+            romanizations[i] = korean_romanizer::romanize(words[i]);
+            pairs[i] = {words[i], romanizations[i]};
+        }
+        return korean_romanizer_dictionary(pairs.data(), pairs.size());
+    }();
+    return dictionary;
+}
+
+/**
+ * A run's output, kept alive so that the optimizer cannot discard the work.
+ */
+std::size_t sink = 0;
+
+const path paths[] = {
+    {"reference", [](const corpus& c, std::vector<std::string>* result) {
+        for (const std::u32string& w : c.code_points) {
+            std::string r = reference_romanizer::romanize(w);
+            sink += r.size();
+            if (result)
+                result->push_back(std::move(r));
+        }
+    }, calls_per_string},
+    {"romanize", [](const corpus& c, std::vector<std::string>* result) {
+        for (const std::string& s : c.strings) {
+            std::string r = korean_romanizer::romanize(s);
+            sink += r.size();
+            if (result)
+                result->push_back(std::move(r));
+        }
+    }, calls_per_string},
+    {"romanize_append", [](const corpus& c, std::vector<std::string>* result) {
+        static std::string r;
+        for (const std::string& s : c.strings) {
+            r.clear();
+            korean_romanizer::romanize(s, r);
+            sink += r.size();
+            if (result)
+                result->push_back(r);
+        }
+    }, calls_per_string},
+    {"romanize_buffer", [](const corpus& c, std::vector<std::string>* result) {
+        static std::string buffer;
+        for (const std::string& s : c.strings) {
+            if (buffer.size() < korean_romanizer::max_romanized_size(s.size()))
+                buffer.resize(korean_romanizer::max_romanized_size(s.size()));
+            const std::size_t size = korean_romanizer::romanize(s, buffer.data());
+            sink += size;
+            if (result)
+                result->emplace_back(buffer.data(), size);
+        }
+    }, calls_per_string},
+    {"romanize_offsets", [](const corpus& c, std::vector<std::string>* result) {
+        static std::string r;
+        static korean_romanizer_offset_map offsets;
+        for (const std::string& s : c.strings) {
+            r.clear();
+            korean_romanizer::romanize(s, r, offsets);
+            sink += r.size() + offsets.romanization_length();
+            if (result)
+                result->push_back(r);
+        }
+    }, calls_per_string, "romanize_append"},
+    {"romanize_dictionary", [](const corpus& c, std::vector<std::string>* result) {
+        static std::string r;
+        const korean_romanizer_dictionary& dictionary = large_dictionary();
+        for (const std::string& s : c.strings) {
+            r.clear();
+            korean_romanizer::romanize(s, r, dictionary);
+            sink += r.size();
+            if (result)
+                result->push_back(r);
+        }
+    }, calls_per_string, "romanize_append"},
+    {"romanize_replace", [](const corpus& c, std::vector<std::string>* result) {
+        static std::string r;
+        for (const std::string& s : c.strings) {
+            r.clear();
+            sink += korean_romanizer::romanize(s, r, korean_romanizer_error_policy::replace).error_count;
+            sink += r.size();
+            if (result)
+                result->push_back(r);
+        }
+    }, calls_per_string, "romanize_append"},
+    {"romanize_parallel", [](const corpus& c, std::vector<std::string>* result) {
+        static std::string r;
+        for (const std::string& s : c.strings) {
+            r.clear();
+            korean_romanizer::romanize_parallel(s, r);
+            sink += r.size();
+            if (result)
+                result->push_back(r);
+        }
+    }, calls_per_string},
+    {"stream", [](const corpus& c, std::vector<std::string>* result) {
+        // fed in chunks that end in the middle of UTF-8 sequences
+        constexpr std::size_t chunk_size = (1 << 16) + 1;
+        static std::string r;
+        korean_romanizer_stream stream;
+        for (const std::string& s : c.strings) {
+            r.clear();
+            for (std::size_t i = 0; i < s.size(); i += chunk_size)
+                stream.feed(std::string_view(s).substr(i, chunk_size), r);
+            stream.finish(r);
+            sink += r.size();
+            if (result)
+                result->push_back(r);
+        }
+    }, calls_per_string},
+    {"batch", [](const corpus& c, std::vector<std::string>* result) {
+        static std::vector<std::string_view> views;
+        static korean_romanizer_batch batch;
+        views.assign(c.strings.begin(), c.strings.end());
+        batch.romanize(views.data(), views.size(), 0);
+        sink += batch.data().size();
+        if (result)
+            for (std::size_t i = 0; i < batch.size(); ++i)
+                result->emplace_back(batch[i]);
+    }, one_call},
+    {"cache", [](const corpus& c, std::vector<std::string>* result) {
+        static korean_romanizer_cache cache;
+        static std::string r;
+        for (const std::string& s : c.strings) {
+            r.clear();
+            cache.romanize(s, r);
+            sink += r.size();
+            if (result)
+                result->push_back(r);
+        }
+    }, calls_per_string},
+};
+
+/**
+ * Checks that every path produces the same romanizations as the reference rules.
+ */
+bool check(const std::vector<corpus>& corpora) {
+    bool passed = true;
+    for (const corpus& c : corpora) {
+        std::vector<std::string> expected;
+        paths[0].romanize(c, &expected);
+        for (const path& p : paths) {
+            std::vector<std::string> actual;
+            p.romanize(c, &actual);
+            if (actual != expected) {
+                std::cerr << p.name << " differs from the reference on the " << c.name << " corpus\n";
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+/**
+ * @brief The measurements of one path over one corpus.
+ */
+struct result {
+    std::string corpus;
+    std::string path;
+    std::size_t bytes;
+    std::size_t syllables;
+    std::size_t calls;
+    double seconds;
+    double allocations_per_call;
+    /**
+     * How much longer the path takes than its baseline on the same corpus, as a fraction, or NaN if it has none.
+     * It is measured separately from <code>seconds</code>, by alternating runs of the two paths.
+     */
+    double overhead;
+};
+
+/**
+ * Runs a path over a corpus until the given time has passed, keeping the fastest run.
+ */
+result measure(const corpus& c, const path& p, const double min_seconds) {
+    using clock = std::chrono::steady_clock;
+    p.romanize(c, nullptr);  // warm up caches and the path's reused storage
+    double best = 0;
+    std::size_t allocations = 0;
+    const clock::time_point start = clock::now();
+    for (std::size_t run = 0; run < 3 || std::chrono::duration<double>(clock::now() - start).count() < min_seconds; ++run) {
+        const std::size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+        const clock::time_point run_start = clock::now();
+        p.romanize(c, nullptr);
+        const double seconds = std::chrono::duration<double>(clock::now() - run_start).count();
+        if (run == 0 || seconds < best) {
+            best = seconds;
+            allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+        }
+    }
+    return {c.name, p.name, c.bytes, c.syllables, p.calls(c), best, static_cast<double>(allocations) / p.calls(c), std::nan("")};
+}
+
+/**
+ * Measures how much longer a path takes than its baseline on a corpus, alternating runs of the two until the given time has passed
+ * so that both are measured under the same conditions, and comparing their fastest runs.
+ */
+double measure_overhead(const corpus& c, const path& p, const path& baseline, const double min_seconds) {
+    using clock = std::chrono::steady_clock;
+    baseline.romanize(c, nullptr);
+    p.romanize(c, nullptr);
+    double best[2] = {0, 0};
+    const clock::time_point start = clock::now();
+    for (std::size_t run = 0; run < 3 || std::chrono::duration<double>(clock::now() - start).count() < min_seconds; ++run) {
+        for (int i = 0; i < 2; ++i) {
+            const clock::time_point run_start = clock::now();
+            (i ? p : baseline).romanize(c, nullptr);
+            const double seconds = std::chrono::duration<double>(clock::now() - run_start).count();
+            if (run == 0 || seconds < best[i])
+                best[i] = seconds;
+        }
+    }
+    return best[1] / best[0] - 1;
+}
+
+void print_csv(const std::vector<result>& results) {
+    std::cout << "corpus,path,bytes,syllables,calls,seconds,mb_per_s,syllables_per_s,ns_per_call,allocations_per_call,overhead\n";
+    for (const result& r : results) {
+        std::cout << r.corpus << ',' << r.path << ',' << r.bytes << ',' << r.syllables << ',' << r.calls << ',' << r.seconds << ','
+                  << r.bytes / r.seconds / 1e6 << ',' << r.syllables / r.seconds << ',' << r.seconds * 1e9 / r.calls << ',' << r.allocations_per_call << ',';
+        if (!std::isnan(r.overhead))
+            std::cout << r.overhead;
+        std::cout << '\n';
+    }
+}
+
+void print_json(const std::vector<result>& results) {
+    std::cout << "[\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const result& r = results[i];
+        std::cout << "  {\"corpus\": \"" << r.corpus << "\", \"path\": \"" << r.path << "\", \"bytes\": " << r.bytes << ", \"syllables\": " << r.syllables
+                  << ", \"calls\": " << r.calls << ", \"seconds\": " << r.seconds << ", \"mb_per_s\": " << r.bytes / r.seconds / 1e6
+                  << ", \"syllables_per_s\": " << r.syllables / r.seconds << ", \"ns_per_call\": " << r.seconds * 1e9 / r.calls
+                  << ", \"allocations_per_call\": " << r.allocations_per_call << ", \"overhead\": ";
+        if (std::isnan(r.overhead))
+            std::cout << "null";
+        else
+            std::cout << r.overhead;
+        std::cout << '}' << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+void print_usage(std::ostream& stream) {
+    stream << "Usage: benchmark [OPTION]...\n"
+              "Check every romanization path against the reference rules on seeded corpora, then measure them.\n"
+              "\n"
+              "  --format=FORMAT    print the results as csv (the default) or json\n"
+              "  --size=BYTES       generate corpora of roughly BYTES bytes (default 4000000)\n"
+              "  --time=SECONDS     measure every path on every corpus for at least SECONDS (default 0.5)\n"
+              "  --check-only       only check the paths against the reference rules\n"
+              "  -h, --help         display this help and exit\n";
+}
+
+int main(const int argc, char** const argv) {
+    std::string_view format = "csv";
+    std::size_t size = 4000000;
+    double min_seconds = 0.5;
+    bool check_only = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        if (argument.rfind("--format=", 0) == 0 && (argument.substr(9) == "csv" || argument.substr(9) == "json")) {
+            format = argument.substr(9);
+        } else if (argument.rfind("--size=", 0) == 0) {
+            size = std::strtoull(argv[i] + 7, nullptr, 10);
+        } else if (argument.rfind("--time=", 0) == 0) {
+            min_seconds = std::strtod(argv[i] + 7, nullptr);
+        } else if (argument == "--check-only") {
+            check_only = true;
+        } else if (argument == "-h" || argument == "--help") {
+            print_usage(std::cout);
+            return 0;
+        } else {
+            std::cerr << "benchmark: invalid option '" << argument << "'\n";
+            print_usage(std::cerr);
+            return 2;
+        }
+    }
+    const std::vector<corpus> corpora = make_corpora(size);
+    if (!check(corpora))
+        return 1;
+    if (check_only)
+        return 0;
+    std::vector<result> results;
+    for (const corpus& c : corpora) {
+        for (const path& p : paths) {
+            results.push_back(measure(c, p, min_seconds));
+            for (const path& baseline : paths)
+                if (p.baseline && baseline.name == p.baseline)
+                    results.back().overhead = measure_overhead(c, p, baseline, min_seconds);
+        }
+    }
+    if (format == "json")
+        print_json(results);
+    else
+        print_csv(results);
+    return sink == 0;
+}
@@ -1,420 +1,2311 @@
 #include "korean_romanizer.h"
 
-#include <locale>
-#include <codecvt>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
-std::string korean_character::leading_consonant_pronunciation::pronunciations[19] = {"g", "kk", "n", "d", "tt", "r", "m", "b", "pp", "s", "ss", "", "j", "jj", "ch", "k", "t", "p", "h"};
-std::string korean_character::leading_consonant_pronunciation::get_pronunciation(const int previous_trailing_consonant_index, const int index) {
-    if (index < 0)
-        return "";
-    switch (index) {
-        // ㄱ
-        case 0:
-            switch (previous_trailing_consonant_index) {
-                case ㄺ:
-                case ㄻ:
-                case ㄼ:
-                case ㄽ:
-                case ㄾ:
-                case ㄿ:
-                case ㅀ:
-                case ㅎ: return "k";
-                default: return pronunciations[index];
-            }
-        // ㄴ
-        case 2:
-            switch (previous_trailing_consonant_index) {
-                case ㄹ:
-                case ㅀ: return "l";
-                default: return pronunciations[index];
-            }
-        // ㄷ
-        case 3:
-            switch (previous_trailing_consonant_index) {
-                case ㄾ:
-                case ㄶ:
-                case ㅎ: return "t";
-                default: return pronunciations[index];
-            }
-        // ㄹ
-        case 5:
-            switch (previous_trailing_consonant_index) {
-                case ㄱ:
-                case ㄲ:
-                case ㄳ:
-                case ㄺ:
-                case ㄼ:
-                case ㄿ:
-                case ㅁ:
-                case ㅂ:
-                case ㅄ:
-                case ㅇ:
-                case ㅋ:
-                case ㅍ: return "n";
-                case ㄴ:
-                case ㄵ:
-                case ㄶ:
-                case ㄷ:
-                case ㄹ:
-                case ㄻ:
-                case ㄽ:
-                case ㄾ:
-                case ㅀ:
-                case ㅅ:
-                case ㅆ:
-                case ㅈ:
-                case ㅊ:
-                case ㅌ:
-                case ㅎ: return "l";
-                default: return pronunciations[index];
-            }
-        // ㅇ
-        case 11:
-            switch (previous_trailing_consonant_index) {
-                case ㄱ:
-                case ㄺ: return "g";
-                case ㄲ: return "kk";
-                case ㄳ:
-                case ㄽ:
-                case ㅄ:
-                case ㅅ: return "s";
-                case ㄴ:
-                case ㄶ: return "n";
-                case ㄷ: return "d";
-                case ㄵ:
-                case ㅈ: return "j";
-                case ㄹ: return "r";
-                case ㅀ: return "l";
-                case ㄻ:
-                case ㅁ: return "m";
-                case ㄼ:
-                case ㅂ: return "b";
-                case ㄾ:
-                case ㅌ: return "ch";
-                case ㅆ: return "ss";
-                case ㅊ: return "ch";
-                case ㅋ: return "k";
-                case ㄿ:
-                case ㅍ: return "p";
-                default: return pronunciations[index];
-            }
-        // ㅈ
-        case 12:
-            switch (previous_trailing_consonant_index) {
-                case ㅎ: return "ch";
-                default: return pronunciations[index];
-            }
-        // ㅉ, ㅊ, ㅋ, ㅌ
-        case 13:
-        case 14:
-        case 15:
-        case 16:
-            switch (previous_trailing_consonant_index) {
-                case ㅈ:
-                case ㅊ: return "ch";
-                default: return pronunciations[index];
-            }
-        // ㅎ
-        case 18:
-            switch (previous_trailing_consonant_index) {
-                case ㄲ: return "kk";
-                case ㄷ:
-                case ㄾ:
-                case ㅈ:
-                case ㅊ:
-                case ㅌ: return "ch";
-                case ㄺ: return "k";
-                case ㅂ:
-                case ㄼ: return "p";
-                case ㄽ: return "s";
-                case ㅀ: return "r";
-                default: return pronunciations[index];
-            }
-        default: return pronunciations[index];
-    }
-}
-std::string korean_character::vowel_pronunciation::pronunciations[22] = {"a", "ae", "ya", "yae", "eo", "e", "yeo", "ye", "o", "wa", "wae", "oe", "yo", "u", "wo", "we", "wi", "yu", "eu", "ui", "i"};
-std::string korean_character::vowel_pronunciation::get_pronunciation(const int index) {
-    if (index < 0)
-        return "";
-    return pronunciations[index];
-}
-std::string korean_character::trailing_consonant_pronunciation::pronunciations[27] = {"k", "k", "k", "n", "n", "n", "d", "l", "k", "m", "l", "l", "l", "l", "l", "m", "p", "p", "t", "t", "ng", "t", "t", "k", "t", "p", "t"};
-std::string korean_character::trailing_consonant_pronunciation::get_pronunciation(const int next_leading_consonant_index, const int index) {
-    if (index < 0)
-        return "";
-    switch (index) {
-        // ㄱ
-        case 0:
-            switch (next_leading_consonant_index) {
-                case ㄲ:
-                case ㅇ:
-                case ㅋ: return "";
-                case ㄴ:
-                case ㅁ:
-                case ㄹ: return "ng";
-                default: return pronunciations[index];
-            }
-        // ㄲ
-        case 1:
-            switch (next_leading_consonant_index) {
-                case ㄲ:
-                case ㅇ:
-                case ㅋ:
-                case ㅎ: return "";
-                case ㄴ:
-                case ㅁ:
-                case ㄹ: return "ng";
-                default: return pronunciations[index];
-            }
-        // ㄳ
-        case 2:
-            switch (next_leading_consonant_index) {
-                case ㄲ:
-                case ㅋ: return "";
-                case ㄴ:
-                case ㅁ:
-                case ㄹ: return "ng";
-                default: return pronunciations[index];
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define KOREAN_ROMANIZER_MMAP
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define KOREAN_ROMANIZER_SSE2
+#define KOREAN_ROMANIZER_SSE41
+#define KOREAN_ROMANIZER_AVX2
+#endif
+
+namespace {
+/**
+ * @brief Stands in for a @link korean_romanizer_offset_map @endlink when no offsets are requested, so that recording them is compiled away.
+ */
+struct no_offsets {
+    static constexpr std::size_t pending_source_size = 3;
+    void record_copy(std::size_t) {}
+    void record_syllable(std::size_t) {}
+};
+
+/**
+ * @brief Stands in for a @link korean_romanizer_dictionary @endlink when none is given, so that matching words is compiled away.
+ */
+struct no_dictionary {
+    static constexpr std::size_t min_word_syllables = 1;
+    std::size_t match(const korean_character*, std::size_t, std::string_view&) const { return 0; }
+};
+/**
+ * @brief Stands in for a handler of invalid UTF-8 when invalid UTF-8 is to be thrown on, so that recovering from it is compiled away.
+ */
+struct no_error_recovery {
+    static constexpr bool recovers = false;
+    char* recover(const char*, std::size_t, char* out) { return out; }
+};
+/**
+ * @brief The counters of @link korean_romanizer_metrics::snapshot @endlink, except for the latency histogram.
+ */
+enum class metric {
+    calls,
+    failed_calls,
+    input_bytes,
+    output_bytes,
+    result_allocations,
+    hangul_characters,
+    other_code_points,
+    invalid_sequences,
+    changed_leading_consonants,
+    changed_trailing_consonants,
+    cache_hits,
+    cache_misses,
+    count
+};
+#ifdef KOREAN_ROMANIZER_METRICS
+/**
+ * @brief The counters of a thread, which only the thread writes to, while snapshots read them from any thread.
+ */
+struct alignas(64) metrics_block {
+    std::atomic<std::uint64_t> values[static_cast<std::size_t>(metric::count)]{};
+    std::atomic<std::uint64_t> latency_histogram[korean_romanizer_metrics::latency_bucket_count]{};
+    /**
+     * Whether a thread owns the block. Once its thread exits, the block is handed to the next new thread, keeping its counts.
+     */
+    std::atomic<bool> owned{true};
+    /**
+     * The next block of the list, which blocks are only ever pushed to.
+     */
+    metrics_block* next = nullptr;
+};
+std::atomic<metrics_block*> metrics_blocks{nullptr};
+std::atomic<bool> latency_histogram_enabled{false};
+/**
+ * The amount of blocks in static storage, which cover that many threads alive at once before any block is allocated.
+ */
+constexpr std::size_t static_metrics_block_count = 256;
+metrics_block static_metrics_blocks[static_metrics_block_count];
+std::atomic<std::size_t> static_metrics_blocks_used{0};
+/**
+ * Takes a block whose thread has exited, or pushes a new one to the list, from static storage while any is left.
+ */
+metrics_block* claim_metrics_block() {
+    for (metrics_block* block = metrics_blocks.load(std::memory_order_acquire); block; block = block->next) {
+        bool owned = false;
+        if (block->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+            return block;
+    }
+    const std::size_t used = static_metrics_blocks_used.fetch_add(1, std::memory_order_relaxed);
+    metrics_block* const block = used < static_metrics_block_count ? &static_metrics_blocks[used] : new metrics_block;
+    block->next = metrics_blocks.load(std::memory_order_relaxed);
+    while (!metrics_blocks.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    return block;
+}
+/**
+ * @brief Owns the block of the current thread until the thread exits.
+ */
+struct thread_metrics {
+    metrics_block* const block = claim_metrics_block();
+    ~thread_metrics() { block->owned.store(false, std::memory_order_release); }
+};
+thread_local thread_metrics current_thread_metrics;
+/**
+ * The depth of the calls the current thread is in, so that calls made by other calls are not counted.
+ */
+thread_local unsigned call_depth = 0;
+/**
+ * Adds to a counter that only the current thread writes to, which needs no read-modify-write.
+ */
+inline void add(std::atomic<std::uint64_t>& counter, const std::uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+inline void record_metric(const metric m, const std::uint64_t n = 1) {
+    add(current_thread_metrics.block->values[static_cast<std::size_t>(m)], n);
+}
+#else
+inline void record_metric(metric, std::uint64_t = 1) {}
+#endif
+/**
+ * @brief Counts a call to a function that romanizes into a string or a buffer, along with the bytes it reads and writes and how long it takes,
+ * unless the call is made by another such function.
+ */
+class call_metrics {
+#ifdef KOREAN_ROMANIZER_METRICS
+    bool outermost;
+    const std::string* result;
+    std::size_t result_size = 0;
+    std::size_t result_capacity = 0;
+    std::uint64_t output_size = 0;
+    int uncaught_exceptions = 0;
+    bool timed = false;
+    std::chrono::steady_clock::time_point start;
+public:
+    explicit call_metrics(const std::size_t input_size, const std::string* const _result = nullptr) : outermost(!call_depth++), result(_result) {
+        if (!outermost)
+            return;
+        record_metric(metric::calls);
+        record_metric(metric::input_bytes, input_size);
+        if (result) {
+            result_size = result->size();
+            result_capacity = result->capacity();
+        }
+        uncaught_exceptions = std::uncaught_exceptions();
+        if ((timed = latency_histogram_enabled.load(std::memory_order_relaxed)))
+            start = std::chrono::steady_clock::now();
+    }
+    ~call_metrics() {
+        --call_depth;
+        if (!outermost)
+            return;
+        if (timed) {
+            const auto nanoseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            std::size_t bucket = 0;
+            while (bucket + 1 < korean_romanizer_metrics::latency_bucket_count && nanoseconds >> (bucket + 1))
+                ++bucket;
+            add(current_thread_metrics.block->latency_histogram[bucket], 1);
+        }
+        if (std::uncaught_exceptions() > uncaught_exceptions)
+            record_metric(metric::failed_calls);
+        if (result) {
+            output_size += result->size() > result_size ? result->size() - result_size : 0;
+            if (result->capacity() != result_capacity)
+                record_metric(metric::result_allocations);
+        }
+        record_metric(metric::output_bytes, output_size);
+    }
+    /**
+     * Sets the amount of bytes the call wrote, for calls that do not write to a result string.
+     */
+    void set_output_size(const std::size_t size) { output_size = size; }
+#else
+public:
+    explicit call_metrics(std::size_t, const std::string* = nullptr) {}
+    void set_output_size(std::size_t) {}
+#endif
+    call_metrics(const call_metrics&) = delete;
+    call_metrics& operator=(const call_metrics&) = delete;
+};
+/**
+ * @brief Marks the work of a call done on another thread, so that the calls made on its behalf are not counted.
+ */
+struct delegated_call_metrics {
+#ifdef KOREAN_ROMANIZER_METRICS
+    delegated_call_metrics() { ++call_depth; }
+    ~delegated_call_metrics() { --call_depth; }
+#else
+    delegated_call_metrics() {}
+#endif
+};
+/**
+ * @brief Handles invalid UTF-8 according to an error policy other than throwing, counting the errors as it goes.
+ */
+struct error_recovery {
+    static constexpr bool recovers = true;
+    korean_romanizer_error_policy policy;
+    /**
+     * The start of the string, which the offsets of errors are relative to.
+     */
+    const char* input;
+    korean_romanizer_result result;
+
+    /**
+     * Writes whatever the policy replaces an error of the given length with.
+     */
+    char* recover(const char* const error, const std::size_t length, char* out) {
+        record_metric(metric::invalid_sequences);
+        if (!result.error_count++)
+            result.first_error_offset = error - input;
+        switch (policy) {
+        case korean_romanizer_error_policy::replace:
+            std::memcpy(out, "\xEF\xBF\xBD", 3);
+            return out + 3;
+        case korean_romanizer_error_policy::pass_through:
+            std::memcpy(out, error, length);
+            return out + length;
+        default:
+            return out;
+        }
+    }
+};
+/**
+ * Grows a string by at most the given size and lets a function write to the new space,
+ * trimming the string to the end returned by the function, or back to its original size if the function throws.
+ */
+template <class Write>
+void append(std::string& result, const std::size_t max_size, Write write) {
+    const std::size_t size = result.size();
+    // resize_and_overwrite must not be left with an exception
+    std::exception_ptr exception;
+    const auto write_or_roll_back = [&](char* const data) -> std::size_t {
+        try {
+            return write(data + size) - data;
+        } catch (...) {
+            exception = std::current_exception();
+            return size;
+        }
+    };
+#ifdef __cpp_lib_string_resize_and_overwrite
+    result.resize_and_overwrite(size + max_size, [&](char* const data, std::size_t) { return write_or_roll_back(data); });
+#else
+    result.resize(size + max_size);
+    result.resize(write_or_roll_back(result.data()));
+#endif
+    if (exception)
+        std::rethrow_exception(exception);
+}
+/**
+ * Returns the length of the UTF-8 sequence starting with the given byte, or 0 if it cannot start a sequence.
+ */
+std::size_t sequence_length(const unsigned char lead) {
+    if (lead < 0x80)
+        return 1;
+    if (lead >= 0xC2 && lead <= 0xDF)
+        return 2;
+    if (lead >= 0xE0 && lead <= 0xEF)
+        return 3;
+    if (lead >= 0xF0 && lead <= 0xF4)
+        return 4;
+    return 0;
+}
+/**
+ * Returns whether a string starts with a conjoining jamo representing a leading consonant, U+1100 to U+1112.
+ */
+bool is_leading_consonant_jamo(const char* const p) {
+    return static_cast<unsigned char>(p[0]) == 0xE1 && static_cast<unsigned char>(p[1]) == 0x84 && static_cast<unsigned char>(p[2]) >= 0x80 && static_cast<unsigned char>(p[2]) <= 0x92;
+}
+/**
+ * Returns whether a string starts with a conjoining jamo representing a vowel, U+1161 to U+1175.
+ */
+bool is_vowel_jamo(const char* const p) {
+    return static_cast<unsigned char>(p[0]) == 0xE1 && static_cast<unsigned char>(p[1]) == 0x85 && static_cast<unsigned char>(p[2]) >= 0xA1 && static_cast<unsigned char>(p[2]) <= 0xB5;
+}
+/**
+ * Returns whether a byte can start a Hangul character or a conjoining jamo, which all start with one of five lead bytes.
+ */
+bool may_start_hangul(const unsigned char lead) {
+    return lead == 0xE1 || (lead >= 0xEA && lead <= 0xED);
+}
+/**
+ * Returns the length of the valid UTF-8 sequence at the start of a string that does not start with ASCII,
+ * or of the maximal part of a sequence that cannot be completed into a valid one, telling which of the two it is.
+ *
+ * Limiting the second byte of a sequence by its lead byte rejects overlong sequences, surrogates and code points above U+10FFFF.
+ */
+std::size_t check_sequence(const char* const begin, const char* const end, bool& valid) {
+    const auto lead = static_cast<unsigned char>(*begin);
+    const std::size_t length = sequence_length(lead);
+    unsigned char low = lead == 0xE0 ? 0xA0 : lead == 0xF0 ? 0x90 : 0x80;
+    unsigned char high = lead == 0xED ? 0x9F : lead == 0xF4 ? 0x8F : 0xBF;
+    std::size_t i = 1;
+    for (; i < length && i < static_cast<std::size_t>(end - begin); ++i) {
+        const auto continuation = static_cast<unsigned char>(begin[i]);
+        if (continuation < low || continuation > high)
+            break;
+        low = 0x80;
+        high = 0xBF;
+    }
+    valid = length && i == length;
+    return i;
+}
+const char* find_non_ascii_scalar(const char* begin, const char* const end) {
+    for (; end - begin >= 8; begin += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, begin, 8);
+        if (word & 0x8080808080808080)
+            break;
+    }
+    while (begin != end && static_cast<unsigned char>(*begin) < 0x80)
+        ++begin;
+    return begin;
+}
+#ifdef KOREAN_ROMANIZER_SSE2
+const char* find_non_ascii_sse2(const char* begin, const char* const end) {
+    for (; end - begin >= 16; begin += 16) {
+        if (const int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin))))
+            return begin + __builtin_ctz(mask);
+    }
+    return find_non_ascii_scalar(begin, end);
+}
+#endif
+#ifdef KOREAN_ROMANIZER_AVX2
+__attribute__((target("avx2"))) const char* find_non_ascii_avx2(const char* begin, const char* const end) {
+    for (; end - begin >= 32; begin += 32) {
+        if (const int mask = _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin))))
+            return begin + __builtin_ctz(mask);
+    }
+    return find_non_ascii_sse2(begin, end);
+}
+#endif
+static_assert(sizeof(korean_character) == sizeof(std::uint16_t), "the decoders store packed jamo indices directly");
+std::size_t decode_hangul_scalar(const char*& begin, const char* const end, korean_character* const result, const std::size_t capacity) {
+    std::size_t count = 0;
+    for (; count < capacity && end - begin >= 3; ++count, begin += 3) {
+        const unsigned b0 = static_cast<unsigned char>(begin[0]);
+        const unsigned b1 = static_cast<unsigned char>(begin[1]);
+        const unsigned b2 = static_cast<unsigned char>(begin[2]);
+        if ((b0 & 0xF0) != 0xE0 || (b1 & 0xC0) != 0x80 || (b2 & 0xC0) != 0x80)
+            break;
+        result[count] = korean_character((b0 & 0x0F) << 12 | (b1 & 0x3F) << 6 | (b2 & 0x3F));
+        if (!result[count].is_korean_character())
+            break;
+    }
+    return count;
+}
+#ifdef KOREAN_ROMANIZER_SSE41
+/**
+ * Validates and decomposes 8 three-byte sequences, given the 16 bytes at their start and the 16 bytes 8 bytes later,
+ * returning their packed jamo indices and a 16-bit mask of the lanes holding Hangul characters.
+ *
+ * Divisions are replaced by multiply-shift: for every character index s,
+ * (s >> 2) * 9363 >> 16 equals s / 28 and (s / 28) * 3121 >> 16 equals s / 588.
+ */
+__attribute__((target("sse4.1"))) inline __m128i decode_hangul_lanes(const __m128i low, const __m128i high, int& valid) {
+    const __m128i first = _mm_or_si128(
+        _mm_shuffle_epi8(low, _mm_setr_epi8(0, -1, 3, -1, 6, -1, 9, -1, 12, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(high, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7, -1, 10, -1, 13, -1)));
+    const __m128i second = _mm_or_si128(
+        _mm_shuffle_epi8(low, _mm_setr_epi8(1, -1, 4, -1, 7, -1, 10, -1, 13, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(high, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, -1, 11, -1, 14, -1)));
+    const __m128i third = _mm_or_si128(
+        _mm_shuffle_epi8(low, _mm_setr_epi8(2, -1, 5, -1, 8, -1, 11, -1, 14, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(high, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, -1, 12, -1, 15, -1)));
+    const __m128i continuation_mask = _mm_set1_epi16(0xC0);
+    const __m128i continuation = _mm_set1_epi16(0x80);
+    __m128i is_hangul = _mm_and_si128(
+        _mm_cmpeq_epi16(_mm_and_si128(first, _mm_set1_epi16(0xF0)), _mm_set1_epi16(0xE0)),
+        _mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(second, continuation_mask), continuation),
+                      _mm_cmpeq_epi16(_mm_and_si128(third, continuation_mask), continuation)));
+    const __m128i c = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, _mm_set1_epi16(0x0F)), 12),
+                                   _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, _mm_set1_epi16(0x3F)), 6),
+                                                _mm_and_si128(third, _mm_set1_epi16(0x3F))));
+    const __m128i s = _mm_sub_epi16(c, _mm_set1_epi16(static_cast<short>(0xAC00)));
+    is_hangul = _mm_and_si128(is_hangul, _mm_cmpeq_epi16(_mm_min_epu16(s, _mm_set1_epi16(11171)), s));
+    valid = _mm_movemask_epi8(is_hangul);
+    const __m128i q = _mm_mulhi_epu16(_mm_srli_epi16(s, 2), _mm_set1_epi16(9363));
+    const __m128i leading_consonant = _mm_mulhi_epu16(q, _mm_set1_epi16(3121));
+    const __m128i vowel = _mm_sub_epi16(q, _mm_mullo_epi16(leading_consonant, _mm_set1_epi16(21)));
+    const __m128i trailing_consonant = _mm_sub_epi16(s, _mm_mullo_epi16(q, _mm_set1_epi16(28)));
+    return _mm_or_si128(_mm_slli_epi16(leading_consonant, 10), _mm_or_si128(_mm_slli_epi16(vowel, 5), trailing_consonant));
+}
+__attribute__((target("sse4.1"))) std::size_t decode_hangul_sse41(const char*& begin, const char* const end, korean_character* const result, const std::size_t capacity) {
+    std::size_t count = 0;
+    while (capacity - count >= 8 && end - begin >= 24) {
+        int valid;
+        const __m128i jamo = decode_hangul_lanes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)),
+                                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 8)), valid);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(result + count), jamo);
+        const int decoded = valid == 0xFFFF ? 8 : __builtin_ctz(~valid) / 2;
+        count += decoded;
+        begin += 3 * decoded;
+        if (decoded < 8)
+            return count;
+    }
+    return count + decode_hangul_scalar(begin, end, result + count, capacity - count);
+}
+#endif
+#ifdef KOREAN_ROMANIZER_AVX2
+/**
+ * Validates and decomposes 16 three-byte sequences like @link decode_hangul_lanes @endlink, 8 in each 128-bit lane,
+ * given the 16 bytes at the start of the sequences of each lane and the 16 bytes 8 bytes later,
+ * returning their packed jamo indices and a 32-bit mask of the lanes holding Hangul characters.
+ */
+__attribute__((target("avx2"))) inline __m256i decode_hangul_lanes_avx2(const __m256i low, const __m256i high, unsigned& valid) {
+    // the byte shuffles of the SSE4.1 decoder, which stay within each lane and so apply to both lanes at once
+    const __m256i first = _mm256_or_si256(
+        _mm256_shuffle_epi8(low, _mm256_broadcastsi128_si256(_mm_setr_epi8(0, -1, 3, -1, 6, -1, 9, -1, 12, -1, -1, -1, -1, -1, -1, -1))),
+        _mm256_shuffle_epi8(high, _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7, -1, 10, -1, 13, -1))));
+    const __m256i second = _mm256_or_si256(
+        _mm256_shuffle_epi8(low, _mm256_broadcastsi128_si256(_mm_setr_epi8(1, -1, 4, -1, 7, -1, 10, -1, 13, -1, -1, -1, -1, -1, -1, -1))),
+        _mm256_shuffle_epi8(high, _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, -1, 11, -1, 14, -1))));
+    const __m256i third = _mm256_or_si256(
+        _mm256_shuffle_epi8(low, _mm256_broadcastsi128_si256(_mm_setr_epi8(2, -1, 5, -1, 8, -1, 11, -1, 14, -1, -1, -1, -1, -1, -1, -1))),
+        _mm256_shuffle_epi8(high, _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, -1, 12, -1, 15, -1))));
+    const __m256i continuation_mask = _mm256_set1_epi16(0xC0);
+    const __m256i continuation = _mm256_set1_epi16(0x80);
+    __m256i is_hangul = _mm256_and_si256(
+        _mm256_cmpeq_epi16(_mm256_and_si256(first, _mm256_set1_epi16(0xF0)), _mm256_set1_epi16(0xE0)),
+        _mm256_and_si256(_mm256_cmpeq_epi16(_mm256_and_si256(second, continuation_mask), continuation),
+                         _mm256_cmpeq_epi16(_mm256_and_si256(third, continuation_mask), continuation)));
+    const __m256i c = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(first, _mm256_set1_epi16(0x0F)), 12),
+                                      _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(second, _mm256_set1_epi16(0x3F)), 6),
+                                                      _mm256_and_si256(third, _mm256_set1_epi16(0x3F))));
+    const __m256i s = _mm256_sub_epi16(c, _mm256_set1_epi16(static_cast<short>(0xAC00)));
+    is_hangul = _mm256_and_si256(is_hangul, _mm256_cmpeq_epi16(_mm256_min_epu16(s, _mm256_set1_epi16(11171)), s));
+    valid = static_cast<unsigned>(_mm256_movemask_epi8(is_hangul));
+    const __m256i q = _mm256_mulhi_epu16(_mm256_srli_epi16(s, 2), _mm256_set1_epi16(9363));
+    const __m256i leading_consonant = _mm256_mulhi_epu16(q, _mm256_set1_epi16(3121));
+    const __m256i vowel = _mm256_sub_epi16(q, _mm256_mullo_epi16(leading_consonant, _mm256_set1_epi16(21)));
+    const __m256i trailing_consonant = _mm256_sub_epi16(s, _mm256_mullo_epi16(q, _mm256_set1_epi16(28)));
+    return _mm256_or_si256(_mm256_slli_epi16(leading_consonant, 10), _mm256_or_si256(_mm256_slli_epi16(vowel, 5), trailing_consonant));
+}
+__attribute__((target("avx2"))) std::size_t decode_hangul_avx2(const char*& begin, const char* const end, korean_character* const result, const std::size_t capacity) {
+    std::size_t count = 0;
+    while (capacity - count >= 16 && end - begin >= 48) {
+        // characters 0 to 7 in the low lane and 8 to 15, which start 24 bytes later, in the high lane
+        const __m256i low = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin))),
+                                                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 24)), 1);
+        const __m256i high = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 8))),
+                                                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 32)), 1);
+        unsigned valid;
+        const __m256i jamo = decode_hangul_lanes_avx2(low, high, valid);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + count), jamo);
+        const int decoded = valid == 0xFFFFFFFF ? 16 : __builtin_ctz(~valid) / 2;
+        count += decoded;
+        begin += 3 * decoded;
+        if (decoded < 16)
+            return count;
+    }
+    return count + decode_hangul_sse41(begin, end, result + count, capacity - count);
+}
+#endif
+}
+
+korean_character::korean_character(const char32_t _c) { decompose_character(_c); }
+void korean_character::decompose_character(const char32_t _c) {
+    const int i = static_cast<int>(_c) - character_min;
+    if (i < 0 || i >= all_jamo_combination_count) {
+        jamo = not_korean_character;
+        return;
+    }
+    const int leading_consonant = i / vowel_and_trailing_consonant_jamo_combination_count;
+    const int vowel = i % vowel_and_trailing_consonant_jamo_combination_count / trailing_consonant_jamo_count;
+    const int trailing_consonant = i % trailing_consonant_jamo_count;
+    jamo = static_cast<std::uint16_t>(leading_consonant << 10 | vowel << 5 | trailing_consonant);
+}
+template <class System>
+std::string basic_romanizer<System>::romanize(const std::string_view s) {
+    std::string result;
+    romanize(s, result);
+    return result;
+}
+template <class System>
+void basic_romanizer<System>::romanize(const std::string_view s, std::string& result) {
+    call_metrics metrics(s.size(), &result);
+    append(result, max_romanized_size(s.size()), [&](char* const out) { return out + romanize(s, out); });
+}
+template <class System>
+std::size_t basic_romanizer<System>::romanize(const std::string_view s, char* const result) {
+    call_metrics metrics(s.size());
+    korean_character previous_character;
+    korean_character pending_character;
+    no_offsets offsets;
+    no_error_recovery errors;
+    char* const out = romanize(s.data(), s.data() + s.size(), result, previous_character, pending_character, offsets, no_dictionary(), errors);
+    const std::size_t size = finish(previous_character, pending_character, out, offsets) - result;
+    metrics.set_output_size(size);
+    return size;
+}
+template <class System>
+void basic_romanizer<System>::romanize(const std::string_view s, std::string& result, korean_romanizer_offset_map& offsets) {
+    call_metrics metrics(s.size(), &result);
+    offsets.clear();
+    offsets.syllable_lengths.reserve(s.size() / 3);
+    try {
+        append(result, max_romanized_size(s.size()), [&](char* const out) {
+            korean_character previous_character;
+            korean_character pending_character;
+            no_error_recovery errors;
+            char* const end = romanize(s.data(), s.data() + s.size(), out, previous_character, pending_character, offsets, no_dictionary(), errors);
+            return finish(previous_character, pending_character, end, offsets);
+        });
+    } catch (...) {
+        offsets.clear();
+        throw;
+    }
+}
+template <class System>
+std::string basic_romanizer<System>::romanize(const std::string_view s, const korean_romanizer_dictionary& dictionary) {
+    std::string result;
+    romanize(s, result, dictionary);
+    return result;
+}
+template <class System>
+void basic_romanizer<System>::romanize(const std::string_view s, std::string& result, const korean_romanizer_dictionary& dictionary) {
+    static_assert(korean_romanizer_dictionary::max_word_syllables <= hangul_block_size, "a word must fit into a single block of decoded Hangul characters");
+    call_metrics metrics(s.size(), &result);
+    // words of the dictionary may take more bytes per Hangul character than the pronunciation rules ever do
+    using table = korean_character::pronunciation_table<System>;
+    const std::size_t max_length = std::max(table::max_length, dictionary.max_length_per_syllable);
+    append(result, s.size() / 3 * max_length + s.size() % 3 + table::copy_length, [&](char* const out) {
+        korean_character previous_character;
+        korean_character pending_character;
+        no_offsets offsets;
+        no_error_recovery errors;
+        char* const end = romanize(s.data(), s.data() + s.size(), out, previous_character, pending_character, offsets, dictionary, errors);
+        return finish(previous_character, pending_character, end, offsets);
+    });
+}
+template <class System>
+korean_romanizer_result basic_romanizer<System>::romanize(const std::string_view s, std::string& result, const korean_romanizer_error_policy policy) {
+    call_metrics metrics(s.size(), &result);
+    if (policy == korean_romanizer_error_policy::throw_exception) {
+        romanize(s, result);
+        return korean_romanizer_result();
+    }
+    error_recovery errors{policy, s.data(), korean_romanizer_result()};
+    // every byte might be replaced by the three bytes of U+FFFD
+    append(result, std::max(max_romanized_size(s.size()), 3 * s.size() + korean_character::pronunciation_table<System>::copy_length), [&](char* const out) {
+        korean_character previous_character;
+        korean_character pending_character;
+        no_offsets offsets;
+        char* const end = romanize(s.data(), s.data() + s.size(), out, previous_character, pending_character, offsets, no_dictionary(), errors);
+        return finish(previous_character, pending_character, end, offsets);
+    });
+    return errors.result;
+}
+template <class System>
+std::string basic_romanizer<System>::romanize_parallel(const std::string_view s, const unsigned thread_count) {
+    std::string result;
+    romanize_parallel(s, result, thread_count);
+    return result;
+}
+template <class System>
+void basic_romanizer<System>::romanize_parallel(const std::string_view s, std::string& result, unsigned thread_count) {
+    call_metrics metrics(s.size(), &result);
+    // querying the hardware is slow next to romanizing a short string
+    if (!thread_count && s.size() >= 2 * min_parallel_chunk_size)
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    const std::size_t chunk_count = std::min<std::size_t>(thread_count, s.size() / min_parallel_chunk_size);
+    if (chunk_count <= 1) {
+        romanize(s, result);
+        return;
+    }
+    struct chunk {
+        const char* begin;
+        const char* end;
+        std::unique_ptr<char[]> romanization;
+        const char* romanization_begin;
+        const char* romanization_end;
+        std::exception_ptr exception;
+    };
+    std::vector<chunk> chunks(chunk_count);
+    const char* const end = s.data() + s.size();
+    for (std::size_t i = 0; i < chunk_count; ++i) {
+        // split at the start of a code point
+        const char* begin = s.data() + s.size() / chunk_count * i;
+        for (int j = 0; i && j < 3 && begin != end && (static_cast<unsigned char>(*begin) & 0xC0) == 0x80; ++j)
+            ++begin;
+        // nor next to a conjoining jamo, which might be composed with the characters around it
+        const auto is_jamo = [&](const char* const p) {
+            return p >= s.data() && end - p >= 3 && static_cast<unsigned char>(p[0]) == 0xE1 && (static_cast<unsigned char>(p[1]) & 0xFC) == 0x84;
+        };
+        while (i && begin != end && (is_jamo(begin) || is_jamo(begin - 3)))
+            begin += std::min<std::size_t>(std::max<std::size_t>(sequence_length(static_cast<unsigned char>(*begin)), 1), end - begin);
+        if (i)
+            begin = std::max(begin, chunks[i - 1].begin);
+        chunks[i].begin = begin;
+        if (i)
+            chunks[i - 1].end = begin;
+    }
+    chunks.back().end = end;
+    const auto romanize_chunk = [&](chunk& c) {
+        try {
+            // the character preceding the chunk is romanized again as a pending character,
+            // so that it affects the first character of the chunk, and dropped afterwards
+            korean_character previous_character;
+            korean_character pending_character;
+            korean_character first_character;
+            korean_character next_character;
+            if (const char* preceding = c.begin - 3; c.begin != s.data() && preceding >= s.data())
+                decode_hangul(preceding, c.begin, &pending_character, 1);
+            if (const char* begin = c.begin; begin != end)
+                decode_hangul(begin, end, &first_character, 1);
+            if (const char* begin = c.end; begin != end)
+                decode_hangul(begin, end, &next_character, 1);
+            char dropped[korean_character::pronunciation_table<System>::max_length + korean_character::pronunciation_table<System>::copy_length];
+            const std::size_t dropped_size = pending_character.is_korean_character()
+                ? pending_character.romanize_character<System>(korean_character(), first_character, dropped) - dropped : 0;
+            c.romanization.reset(new char[max_romanized_size(c.end - c.begin + 3)]);
+            no_offsets offsets;
+            no_error_recovery errors;
+            char* out = romanize(c.begin, c.end, c.romanization.get(), previous_character, pending_character, offsets, no_dictionary(), errors);
+            if (pending_character.is_korean_character())
+                out = pending_character.romanize_character<System>(previous_character, next_character, out);
+            c.romanization_begin = c.romanization.get() + dropped_size;
+            c.romanization_end = out;
+        } catch (...) {
+            c.exception = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(chunk_count - 1);
+    for (std::size_t i = 1; i < chunk_count; ++i)
+        threads.emplace_back(romanize_chunk, std::ref(chunks[i]));
+    romanize_chunk(chunks.front());
+    for (std::thread& thread : threads)
+        thread.join();
+    std::size_t size = 0;
+    for (const chunk& c : chunks) {
+        if (c.exception)
+            std::rethrow_exception(c.exception);
+        size += c.romanization_end - c.romanization_begin;
+    }
+    append(result, size, [&](char* out) {
+        for (const chunk& c : chunks) {
+            std::memcpy(out, c.romanization_begin, c.romanization_end - c.romanization_begin);
+            out += c.romanization_end - c.romanization_begin;
+        }
+        return out;
+    });
+}
+template <class System>
+template <class Offsets, class Dictionary, class Errors>
+char* basic_romanizer<System>::romanize(const char* begin, const char* const end, char* out, korean_character& previous_character, korean_character& pending_character, Offsets& offsets, const Dictionary& dictionary, Errors& errors) {
+    // the previous character, up to a block of Hangul characters, and the next character
+    korean_character window[hangul_block_size + 2];
+    window[0] = previous_character;
+    window[1] = pending_character;
+    std::size_t count = pending_character.is_korean_character();
+    // the length of every character of the window in bytes, which only offsets need
+    constexpr bool records_source_sizes = !std::is_same_v<Offsets, no_offsets>;
+    unsigned char source_size_storage[records_source_sizes ? hangul_block_size + 2 : 1];
+    unsigned char* const source_sizes = records_source_sizes ? source_size_storage : nullptr;
+    if constexpr (records_source_sizes)
+        source_sizes[1] = static_cast<unsigned char>(offsets.pending_source_size);
+    // replaces the words of the dictionary the run in the window starts with, returning whether any of the run is left
+    const auto replace_words = [&] {
+        std::string_view romanization;
+        // the character following a word of the dictionary starts a word itself, which can be in the dictionary too
+        while (const std::size_t matched = dictionary.match(window + 1, count, romanization)) {
+            std::memcpy(out, romanization.data(), romanization.size());
+            out += romanization.size();
+            for (std::size_t i = 0; i < matched; ++i)
+                record_syllable(offsets, i ? 0 : romanization.size(), source_sizes ? source_sizes[1 + i] : 3);
+            // the rest of the run is romanized as if it started a new word, refilled so that a short run still means it has ended
+            std::copy(window + 1 + matched, window + 1 + count, window + 1);
+            if (source_sizes)
+                std::copy(source_sizes + 1 + matched, source_sizes + 1 + count, source_sizes + 1);
+            count -= matched;
+            count += decode_syllables(begin, end, window + 1 + count, hangul_block_size + 1 - count, source_sizes ? source_sizes + 1 + count : nullptr);
+            if (!count)
+                break;
+        }
+        return count != 0;
+    };
+    // unless offsets have been recorded for it, a run is romanized while the filters of the dictionary are read for it,
+    // and romanized again in the rare case that it starts with a word, which would otherwise wait on memory for every run
+    constexpr bool checks_words_late = !std::is_same_v<Dictionary, no_dictionary> && !records_source_sizes;
+    for (;;) {
+        // where the romanization of a run starts, while it is not known whether the run starts with a word of the dictionary
+        [[maybe_unused]] char* unchecked_run = nullptr;
+        if (count) {
+            count += decode_syllables(begin, end, window + 1 + count, hangul_block_size + 1 - count, source_sizes ? source_sizes + 1 + count : nullptr);
+        } else {
+            if (begin == end)
+                break;
+            if (static_cast<unsigned char>(*begin) < 0x80) {
+                // ASCII never affects its neighbors, so the whole run can be copied at once
+                const char* const ascii_end = find_non_ascii(begin, end);
+                std::memcpy(out, begin, ascii_end - begin);
+                offsets.record_copy(ascii_end - begin);
+                record_metric(metric::other_code_points, ascii_end - begin);
+                out += ascii_end - begin;
+                begin = ascii_end;
+                continue;
             }
-        // ㄴ
-        case 3:
-            switch (next_leading_consonant_index) {
-                case ㄹ: return "l";
-                case ㅇ: return "";
-                default: return pronunciations[index];
+            // a run of Hangul characters always follows a character that is not Hangul
+            window[0] = korean_character();
+            // other characters skip decoding altogether
+            count = may_start_hangul(*begin) ? decode_syllables(begin, end, window + 1, hangul_block_size + 1, source_sizes ? source_sizes + 1 : nullptr) : 0;
+            if (!count) {
+                // a run of other characters, or of errors, stays in this loop until ASCII or what might be Hangul follows
+                do {
+                    const char* const character_begin = begin;
+                    if constexpr (Errors::recovers) {
+                        bool valid;
+                        begin += check_sequence(begin, end, valid);
+                        if (!valid) {
+                            out = errors.recover(character_begin, begin - character_begin, out);
+                            continue;
+                        }
+                    } else {
+                        decode_character(begin, end);
+                    }
+                    std::memcpy(out, character_begin, begin - character_begin);
+                    offsets.record_copy(begin - character_begin);
+                    record_metric(metric::other_code_points);
+                    out += begin - character_begin;
+                } while (begin != end && static_cast<unsigned char>(*begin) >= 0x80 && !may_start_hangul(*begin));
+                continue;
             }
-        // ㄷ
-        case 6:
-            switch (next_leading_consonant_index) {
-                case ㄴ:
-                case ㅁ: return "n";
-                case ㄹ: return "l";
-                case ㄸ:
-                case ㅇ:
-                case ㅌ:
-                case ㅎ: return "";
-                default: return pronunciations[index];
+            // a run shorter than every word of the dictionary cannot start with one
+            if (count >= dictionary.min_word_syllables) {
+                if constexpr (checks_words_late) {
+                    dictionary.prefetch(window + 1);
+                    unchecked_run = out;
+                } else if (!replace_words()) {
+                    continue;
+                }
             }
-        // ㄹ
-        case 7:
-            switch (next_leading_consonant_index) {
-                case ㅇ: return "";
-                default: return pronunciations[index];
+        }
+        // unless the run was cut short by a character that is not Hangul, its last character
+        // cannot be romanized until the character following it has been decoded
+        const bool ended = begin != end && count <= hangul_block_size;
+        if (ended)
+            window[count + 1] = korean_character();
+        const std::size_t romanized = ended ? count : count - 1;
+        for (std::size_t i = 1; i <= romanized; ++i) {
+            char* const character_out = out;
+            out = window[i].romanize_character<System>(window[i - 1], window[i + 1], out);
+            record_syllable(offsets, out - character_out, source_sizes ? source_sizes[i] : 3);
+        }
+        if constexpr (checks_words_late) {
+            std::string_view romanization;
+            if (unchecked_run && dictionary.match(window + 1, count, romanization)) {
+                // the rest of the run, if any, is decoded and romanized as a run that continues
+                out = unchecked_run;
+                replace_words();
+                continue;
             }
-        // ㄺ
-        case 8:
-            switch (next_leading_consonant_index) {
-                case ㄱ:
-                case ㄲ:
-                case ㅇ:
-                case ㅎ: return "l";
-                case ㄴ:
-                case ㄹ:
-                case ㅁ: return "ng";
-                default: return pronunciations[index];
+        }
+        count_romanized(window, romanized);
+        if (ended) {
+            count = 0;
+            continue;
+        }
+        window[0] = window[count - 1];
+        window[1] = window[count];
+        if (source_sizes)
+            source_sizes[1] = source_sizes[count];
+        count = 1;
+        if (begin == end)
+            break;
+    }
+    previous_character = count ? window[0] : korean_character();
+    pending_character = count ? window[1] : korean_character();
+    if constexpr (records_source_sizes)
+        offsets.pending_source_size = count ? source_sizes[1] : 3;
+    return out;
+}
+template <class System>
+template <class Offsets>
+void basic_romanizer<System>::record_syllable(Offsets& offsets, const std::size_t size, std::size_t source_size) {
+    offsets.record_syllable(size);
+    for (; source_size > 3; source_size -= 3)
+        offsets.record_syllable(0);
+}
+template <class System>
+void basic_romanizer<System>::count_romanized([[maybe_unused]] const korean_character* const window, [[maybe_unused]] const std::size_t count) {
+#ifdef KOREAN_ROMANIZER_METRICS
+    using table = korean_character::pronunciation_table<System>;
+    const auto same = [](const typename table::entry a, const typename table::entry b) {
+        return table::blob.substr(a.offset, a.length) == table::blob.substr(b.offset, b.length);
+    };
+    std::uint64_t changed_leading_consonants = 0;
+    std::uint64_t changed_trailing_consonants = 0;
+    for (std::size_t i = 1; i <= count; ++i) {
+        const unsigned leading_consonant = window[i].leading_consonant(), trailing_consonant = window[i].trailing_consonant();
+        changed_leading_consonants += !same(table::leading_consonants[window[i - 1].trailing_consonant()][leading_consonant], table::leading_consonants[0][leading_consonant]);
+        changed_trailing_consonants += !same(table::trailing_consonants[trailing_consonant][window[i + 1].leading_consonant()], table::trailing_consonants[trailing_consonant][19]);
+    }
+    record_metric(metric::hangul_characters, count);
+    record_metric(metric::changed_leading_consonants, changed_leading_consonants);
+    record_metric(metric::changed_trailing_consonants, changed_trailing_consonants);
+#endif
+}
+template <class System>
+template <class Offsets>
+char* basic_romanizer<System>::finish(korean_character& previous_character, korean_character& pending_character, char* out, Offsets& offsets) {
+    if (pending_character.is_korean_character()) {
+        char* const character_out = out;
+        out = pending_character.romanize_character<System>(previous_character, korean_character(), out);
+        record_syllable(offsets, out - character_out, offsets.pending_source_size);
+        const korean_character window[] = {previous_character, pending_character, korean_character()};
+        count_romanized(window, 1);
+    }
+    previous_character = korean_character();
+    pending_character = korean_character();
+    return out;
+}
+template <class System>
+char32_t basic_romanizer<System>::decode_character(const char*& begin, const char* const end) {
+    const auto byte = [](const char c) { return static_cast<unsigned char>(c); };
+    const unsigned char lead = byte(*begin);
+    if (lead < 0x80) {
+        ++begin;
+        return lead;
+    }
+    const std::size_t length = sequence_length(lead);
+    if (!length)
+        throw std::range_error("korean_romanizer::romanize: invalid UTF-8 lead byte");
+    char32_t c = lead & (0x7F >> length);
+    constexpr char32_t min[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (static_cast<std::size_t>(end - begin) < length)
+        throw std::range_error("korean_romanizer::romanize: truncated UTF-8 sequence");
+    for (std::size_t i = 1; i < length; ++i) {
+        const unsigned char continuation = byte(begin[i]);
+        if ((continuation & 0xC0) != 0x80)
+            throw std::range_error("korean_romanizer::romanize: invalid UTF-8 continuation byte");
+        c = c << 6 | (continuation & 0x3F);
+    }
+    if (c < min[length] || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        throw std::range_error("korean_romanizer::romanize: invalid UTF-8 code point");
+    begin += length;
+    return c;
+}
+template <class System>
+const char* basic_romanizer<System>::find_non_ascii(const char* const begin, const char* const end) {
+    static const auto implementation = [] {
+#ifdef KOREAN_ROMANIZER_AVX2
+        if (__builtin_cpu_supports("avx2"))
+            return find_non_ascii_avx2;
+#endif
+#ifdef KOREAN_ROMANIZER_SSE2
+        return find_non_ascii_sse2;
+#else
+        return find_non_ascii_scalar;
+#endif
+    }();
+    return implementation(begin, end);
+}
+template <class System>
+std::size_t basic_romanizer<System>::decode_hangul(const char*& begin, const char* const end, korean_character* const result, const std::size_t capacity) {
+    static const auto implementation = [] {
+#ifdef KOREAN_ROMANIZER_AVX2
+        if (__builtin_cpu_supports("avx2"))
+            return decode_hangul_avx2;
+#endif
+#ifdef KOREAN_ROMANIZER_SSE41
+        if (__builtin_cpu_supports("sse4.1"))
+            return decode_hangul_sse41;
+#endif
+        return decode_hangul_scalar;
+    }();
+    return implementation(begin, end, result, capacity);
+}
+template <class System>
+std::size_t basic_romanizer<System>::decode_syllables(const char*& begin, const char* const end, korean_character* const result, const std::size_t capacity, unsigned char* const source_sizes) {
+    // conjoining jamo are U+1100 to U+11FF, which are E1 84 80 to E1 87 BF, returned relative to U+1100
+    const auto jamo = [end](const char* const p) {
+        const auto byte = [p](const int i) { return static_cast<unsigned char>(p[i]); };
+        if (end - p < 3 || byte(0) != 0xE1 || (byte(1) & 0xFC) != 0x84 || (byte(2) & 0xC0) != 0x80)
+            return -1;
+        return (byte(1) & 0x03) << 6 | (byte(2) & 0x3F);
+    };
+    constexpr int leading_consonant_min = korean_character::leading_consonant_jamo_min - 0x1100;
+    constexpr int vowel_min = korean_character::vowel_jamo_min - 0x1100;
+    constexpr int trailing_consonant_min = korean_character::trailing_consonant_jamo_min - 0x1100;
+    std::size_t count = 0;
+    for (;;) {
+        // a run of jamo does not need to go through the decoder for composed characters between every character
+        if (begin != end && static_cast<unsigned char>(*begin) != 0xE1) {
+            const std::size_t decoded = decode_hangul(begin, end, result + count, capacity - count);
+            if (source_sizes)
+                std::fill(source_sizes + count, source_sizes + count + decoded, 3);
+            count += decoded;
+        }
+        if (count == capacity)
+            return count;
+        const int first = jamo(begin);
+        if (first > trailing_consonant_min && first < trailing_consonant_min + korean_character::trailing_consonant_jamo_count) {
+            korean_character& previous = result[static_cast<std::ptrdiff_t>(count) - 1];
+            if (!previous.is_korean_character() || previous.trailing_consonant())
+                return count;
+            previous.jamo |= first - trailing_consonant_min;
+            if (source_sizes)
+                source_sizes[static_cast<std::ptrdiff_t>(count) - 1] += 3;
+            begin += 3;
+            continue;
+        }
+        if (first < leading_consonant_min || first >= leading_consonant_min + korean_character::leading_consonant_jamo_count)
+            return count;
+        const int vowel = jamo(begin + 3) - vowel_min;
+        if (vowel < 0 || vowel >= korean_character::vowel_jamo_count)
+            return count;
+        result[count].jamo = static_cast<std::uint16_t>((first - leading_consonant_min) << 10 | vowel << 5);
+        begin += 6;
+        std::size_t size = 6;
+        if (const int trailing_consonant = jamo(begin) - trailing_consonant_min; trailing_consonant > 0 && trailing_consonant < korean_character::trailing_consonant_jamo_count) {
+            result[count].jamo |= trailing_consonant;
+            begin += 3;
+            size = 9;
+        }
+        if (source_sizes)
+            source_sizes[count] = static_cast<unsigned char>(size);
+        ++count;
+    }
+}
+template <class System>
+void basic_romanizer_stream<System>::feed(std::string_view chunk, std::string& result) {
+    call_metrics metrics(chunk.size(), &result);
+    const std::size_t max_size = basic_romanizer<System>::max_romanized_size(partial_sequence_size + chunk.size() + 3);
+    no_offsets offsets;
+    no_error_recovery errors;
+    append(result, max_size, [&](char* out) {
+        const auto romanize = [&](const char* const begin, const char* const end) {
+            out = basic_romanizer<System>::romanize(begin, end, out, previous_character, pending_character, offsets, no_dictionary(), errors);
+        };
+        while (partial_sequence_size) {
+            // a held back leading consonant waits for the character following it to be complete
+            const std::size_t sequence_begin = partial_sequence_size >= 3 && is_leading_consonant_jamo(partial_sequence) ? 3 : 0;
+            if (partial_sequence_size == sequence_begin) {
+                if (chunk.empty())
+                    return out;
+                partial_sequence[partial_sequence_size++] = chunk[0];
+                chunk.remove_prefix(1);
             }
-        // ㄻ
-        case 9:
-            switch (next_leading_consonant_index) {
-                case ㄹ:
-                case ㅁ:
-                case ㅇ: return "l";
-                default: return pronunciations[index];
+            const std::size_t sequence_end = sequence_begin + std::max<std::size_t>(sequence_length(partial_sequence[sequence_begin]), 1);
+            const std::size_t missing = std::min(sequence_end - partial_sequence_size, chunk.size());
+            std::memcpy(partial_sequence + partial_sequence_size, chunk.data(), missing);
+            partial_sequence_size += missing;
+            chunk.remove_prefix(missing);
+            if (partial_sequence_size < sequence_end)
+                return out;
+            if (!sequence_begin && is_leading_consonant_jamo(partial_sequence) && partial_sequence_size == 3)
+                continue;
+            if (sequence_begin && !is_vowel_jamo(partial_sequence + 3)) {
+                // the leading consonant stands alone, while the character following it might be a leading consonant itself
+                romanize(partial_sequence, partial_sequence + 3);
+                partial_sequence_size -= 3;
+                std::memmove(partial_sequence, partial_sequence + 3, partial_sequence_size);
+                continue;
             }
-        // ㄼ
-        case 10:
-            switch (next_leading_consonant_index) {
-                case ㄴ:
-                case ㄹ: return "m";
-                case ㄷ:
-                case ㄸ:
-                case ㅂ:
-                case ㅅ:
-                case ㅆ:
-                case ㅈ:
-                case ㅉ:
-                case ㅊ:
-                case ㅋ:
-                case ㅌ:
-                case ㅎ: return "p";
-                case ㅃ: return "";
-                default: return pronunciations[index];
+            romanize(partial_sequence, partial_sequence + partial_sequence_size);
+            partial_sequence_size = 0;
+        }
+        // hold back a UTF-8 sequence cut off at the end of the chunk
+        for (std::size_t i = 1; i <= 3 && i <= chunk.size(); ++i) {
+            const auto byte = static_cast<unsigned char>(chunk[chunk.size() - i]);
+            if ((byte & 0xC0) == 0x80)
+                continue;
+            if (sequence_length(byte) > i) {
+                std::memcpy(partial_sequence, chunk.data() + chunk.size() - i, i);
+                partial_sequence_size = i;
+                chunk.remove_suffix(i);
             }
-        // ㄿ
-        case 13:
-            switch (next_leading_consonant_index) {
-                case ㄴ:
-                case ㄹ: return "m";
-                case ㄷ:
-                case ㄸ:
-                case ㅂ:
-                case ㅅ:
-                case ㅆ:
-                case ㅈ:
-                case ㅉ:
-                case ㅊ:
-                case ㅋ:
-                case ㅌ:
-                case ㅎ: return "p";
-                case ㅃ:
-                case ㅍ: return "";
-                default: return pronunciations[index];
+            break;
+        }
+        // and a leading consonant jamo before it, which the next chunk might compose into a Hangul character
+        if (chunk.size() >= 3 && is_leading_consonant_jamo(chunk.data() + chunk.size() - 3)) {
+            std::memmove(partial_sequence + 3, partial_sequence, partial_sequence_size);
+            std::memcpy(partial_sequence, chunk.data() + chunk.size() - 3, 3);
+            partial_sequence_size += 3;
+            chunk.remove_suffix(3);
+        }
+        romanize(chunk.data(), chunk.data() + chunk.size());
+        return out;
+    });
+}
+template <class System>
+void basic_romanizer_stream<System>::finish(std::string& result) {
+    call_metrics metrics(0, &result);
+    // a leading consonant jamo ending the string is left untouched, like any other that is not followed by a vowel
+    if (partial_sequence_size && (partial_sequence_size != 3 || !is_leading_consonant_jamo(partial_sequence))) {
+        // the characters held back are dropped along with it, so that they do not leak into the next string
+        *this = basic_romanizer_stream();
+        throw std::range_error("korean_romanizer_stream::finish: truncated UTF-8 sequence");
+    }
+    append(result, basic_romanizer<System>::max_romanized_size(partial_sequence_size + 3), [&](char* out) {
+        no_offsets offsets;
+        no_error_recovery errors;
+        out = basic_romanizer<System>::romanize(partial_sequence, partial_sequence + partial_sequence_size, out, previous_character, pending_character, offsets, no_dictionary(), errors);
+        partial_sequence_size = 0;
+        return basic_romanizer<System>::finish(previous_character, pending_character, out, offsets);
+    });
+}
+template <class System>
+void basic_romanizer_batch<System>::romanize(const std::string_view* const strings, const std::size_t count, unsigned thread_count) {
+    std::size_t total_size = 0;
+    for (std::size_t i = 0; i < count; ++i)
+        total_size += strings[i].size();
+    if (!thread_count && total_size >= 2 * basic_romanizer<System>::min_parallel_chunk_size)
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    const std::size_t group_count = std::max<std::size_t>(std::min<std::size_t>(thread_count, total_size / basic_romanizer<System>::min_parallel_chunk_size), 1);
+    // split the strings into groups of similar size, each writing to its own part of the buffer
+    struct group {
+        std::size_t first;
+        std::size_t last;
+        std::size_t buffer_begin;
+        std::size_t buffer_end;
+        std::exception_ptr exception;
+    };
+    // a single group, the common case for small batches, does not need to be allocated
+    group single_group{};
+    std::vector<group> group_storage(group_count > 1 ? group_count : 0);
+    group* const groups = group_count > 1 ? group_storage.data() : &single_group;
+    std::size_t size = 0;
+    std::size_t i = 0;
+    std::size_t buffer_size = 0;
+    for (std::size_t g = 0; g < group_count; ++g) {
+        groups[g].first = i;
+        std::size_t group_size = 0;
+        while (i < count && (g + 1 == group_count || size < total_size / group_count * (g + 1))) {
+            size += strings[i].size();
+            group_size += strings[i++].size();
+        }
+        groups[g].last = i;
+        groups[g].buffer_begin = buffer_size;
+        buffer_size += basic_romanizer<System>::max_romanized_size(group_size);
+    }
+    romanization_offsets.resize(count + 1);
+    romanizations.clear();
+    call_metrics metrics(total_size, &romanizations);
+    std::size_t end = 0;
+    try {
+        append(romanizations, buffer_size, [&](char* const data) {
+            const auto romanize_group = [&](group& g) {
+                delegated_call_metrics delegated;
+                try {
+                    std::size_t offset = g.buffer_begin;
+                    for (std::size_t j = g.first; j < g.last; ++j) {
+                        romanization_offsets[j] = static_cast<std::int64_t>(offset);
+                        offset += basic_romanizer<System>::romanize(strings[j], data + offset);
+                    }
+                    g.buffer_end = offset;
+                } catch (...) {
+                    g.exception = std::current_exception();
+                }
+            };
+            std::vector<std::thread> threads;
+            threads.reserve(group_count - 1);
+            for (std::size_t g = 1; g < group_count; ++g)
+                threads.emplace_back(romanize_group, std::ref(groups[g]));
+            romanize_group(groups[0]);
+            for (std::thread& thread : threads)
+                thread.join();
+            // close the gaps left between the groups
+            for (std::size_t index = 0; index < group_count; ++index) {
+                const group& g = groups[index];
+                if (g.exception)
+                    std::rethrow_exception(g.exception);
+                const std::size_t shift = g.buffer_begin - end;
+                if (shift) {
+                    std::memmove(data + end, data + g.buffer_begin, g.buffer_end - g.buffer_begin);
+                    for (std::size_t j = g.first; j < g.last; ++j)
+                        romanization_offsets[j] -= static_cast<std::int64_t>(shift);
+                }
+                end += g.buffer_end - g.buffer_begin;
             }
-        // ㅀ
-        case 14:
-            switch (next_leading_consonant_index) {
-                case ㅎ:
-                case ㅇ: return "";
-                default: return pronunciations[index];
+            return data + end;
+        });
+    } catch (...) {
+        romanization_offsets.assign(1, 0);
+        throw;
+    }
+    romanization_offsets[count] = static_cast<std::int64_t>(end);
+}
+template <class System>
+struct alignas(64) basic_romanizer_cache<System>::shard {
+    /**
+     * The amount of slots a word can be cached in.
+     */
+    static constexpr std::size_t bucket_size = 4;
+    /**
+     * The length of the longest romanization that is cached, in bytes, filling the rest of a slot.
+     */
+    static constexpr std::size_t max_romanization_size = 80;
+    /**
+     * @brief A cached word and its romanization, stored inline and guarded by a sequence number.
+     * @details The word and its romanization are stored in atomic words, which lookups load without a lock,
+     * and only keep if the sequence number was even and unchanged while they loaded them.
+     * Insertions make the sequence number odd while they store a new word and romanization.
+     * The atomic words are stored with release and loaded with acquire ordering instead of being fenced,
+     * so a lookup that loads a word of a newer insertion also sees the sequence number it changed.
+     */
+    struct alignas(128) slot {
+        std::atomic<std::uint32_t> sequence{0};
+        /**
+         * Whether the word has been found since the CLOCK hand last passed it.
+         */
+        std::atomic<bool> referenced{false};
+        /**
+         * The size of the word in the lowest byte and the size of its romanization in the next one, or 0 if the slot is empty.
+         */
+        std::atomic<std::uint64_t> sizes{0};
+        std::atomic<std::uint64_t> word[key_size] = {};
+        std::atomic<std::uint64_t> romanization[max_romanization_size / 8] = {};
+    };
+    static_assert(sizeof(slot) == 128, "a slot must fill two cache lines exactly");
+    /**
+     * @brief The slots a word can be cached in, chosen by its hash.
+     */
+    struct bucket {
+        slot slots[bucket_size];
+    };
+    /**
+     * Taken by insertions, which lookups never wait for.
+     */
+    std::mutex mutex;
+    std::unique_ptr<bucket[]> buckets;
+    /**
+     * The 16-bit tags of the words in the slots of every bucket, taken from their hashes, or 0 for an empty slot.
+     * A lookup only reads the slots with the tag of its word, so that it rarely touches more than one slot.
+     */
+    std::unique_ptr<std::atomic<std::uint64_t>[]> tags;
+    /**
+     * The slot of every bucket the CLOCK hand points at, which is the next candidate for eviction.
+     */
+    std::unique_ptr<unsigned char[]> hands;
+    std::size_t bucket_count = 0;
+    /**
+     * The amount of slots in use, which only grows until the shard is full.
+     */
+    std::atomic<std::size_t> size{0};
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    /**
+     * @return Whether a slot holds a word, comparing every atomic word of the key at once as they are all padded with zeros.
+     * When called without holding the lock, the slot may change while it is compared, so the sequence number needs to be checked afterwards.
+     */
+    static bool holds(const slot& s, const std::uint64_t (&key)[key_size], const std::size_t word_size) {
+        std::uint64_t difference = (s.sizes.load(std::memory_order_acquire) & 0xFF) ^ word_size;
+        for (std::size_t i = 0; i < key_size; ++i)
+            difference |= s.word[i].load(std::memory_order_acquire) ^ key[i];
+        return !difference;
+    }
+    /**
+     * Writes a word and its romanization into a slot while holding the lock.
+     */
+    static void write(slot& s, const std::uint64_t (&key)[key_size], const std::size_t word_size, const std::string_view romanization) {
+        const std::uint32_t sequence = s.sequence.load(std::memory_order_relaxed);
+        s.sequence.store(sequence + 1, std::memory_order_relaxed);
+        s.sizes.store(word_size | romanization.size() << 8, std::memory_order_release);
+        for (std::size_t i = 0; i < key_size; ++i)
+            s.word[i].store(key[i], std::memory_order_release);
+        for (std::size_t i = 0; i < romanization.size(); i += 8) {
+            std::uint64_t w = 0;
+            std::memcpy(&w, romanization.data() + i, std::min<std::size_t>(romanization.size() - i, 8));
+            s.romanization[i / 8].store(w, std::memory_order_release);
+        }
+        s.referenced.store(false, std::memory_order_relaxed);
+        s.sequence.store(sequence + 2, std::memory_order_release);
+    }
+    /**
+     * Writes the romanization of a word, looking it up first and inserting it on a miss.
+     *
+     * @param key The word, padded with zeros to whole atomic words.
+     * @param hash The hash of the word.
+     * @param out The buffer to write the romanization to, which needs room for @link basic_romanizer::max_romanized_size @endlink bytes
+     * and @link max_romanization_size @endlink bytes past the end of the romanization.
+     * @param found Counts the word if it was found, which is added to @link hits @endlink once per string rather than once per word.
+     * @return The end of the romanization.
+     */
+    char* romanize(const std::string_view word, const std::uint64_t (&key)[key_size], const std::uint64_t hash, char* const out, std::uint64_t& found) {
+        const std::size_t index = static_cast<std::size_t>((hash >> 32) * bucket_count >> 32);
+        const std::uint64_t tag = (hash & 0xFFFF) | 1;
+        bucket& b = buckets[index];
+        // finds the slots with the tag of the word, setting the highest bit of their tags in the differences
+        constexpr std::uint64_t lowest_bits = 0x0001000100010001;
+        const std::uint64_t differences = tags[index].load(std::memory_order_relaxed) ^ tag * lowest_bits;
+        for (std::uint64_t matches = (differences - lowest_bits) & ~differences & lowest_bits << 15; matches; matches &= matches - 1) {
+            // the lowest match is bit 16 * i + 15, which the multiplication turns into i in the highest 16 bits
+            slot& s = b.slots[((matches & (~matches + 1)) >> 15) * 0x0000000100020003 >> 48];
+            // a slot that is being written or changes while it is read is skipped, as if the word was missing
+            const std::uint32_t sequence = s.sequence.load(std::memory_order_acquire);
+            if (sequence & 1 || !holds(s, key, word.size()))
+                continue;
+            // the whole romanization is copied, rather than as many bytes as it takes, to avoid branching on its size,
+            // and is simply overwritten if the slot turns out to have changed
+            const std::size_t romanization_size = std::min<std::size_t>(s.sizes.load(std::memory_order_acquire) >> 8 & 0xFF, max_romanization_size);
+            for (std::size_t i = 0; i < max_romanization_size / 8; ++i) {
+                const std::uint64_t w = s.romanization[i].load(std::memory_order_acquire);
+                std::memcpy(out + i * 8, &w, 8);
             }
-        // ㅁ
-        case 15:
-            switch (next_leading_consonant_index) {
-                case ㅇ: return "";
-                default: return pronunciations[index];
+            if (s.sequence.load(std::memory_order_relaxed) != sequence)
+                continue;
+            if (!s.referenced.load(std::memory_order_relaxed))
+                s.referenced.store(true, std::memory_order_relaxed);
+            ++found;
+            record_metric(metric::cache_hits);
+            return out + romanization_size;
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        record_metric(metric::cache_misses);
+        const std::string_view romanization(out, basic_romanizer<System>::romanize(word, out));
+        if (romanization.size() > max_romanization_size)
+            return out + romanization.size();
+        std::lock_guard lock(mutex);
+        std::size_t chosen = bucket_size;
+        for (std::size_t i = 0; i < bucket_size; ++i) {
+            // another thread may have inserted the word in the meantime
+            if (holds(b.slots[i], key, word.size()))
+                return out + romanization.size();
+            if (chosen == bucket_size && !b.slots[i].sizes.load(std::memory_order_relaxed))
+                chosen = i;
+        }
+        if (chosen < bucket_size) {
+            size.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // give every recently found word a second chance
+            unsigned char& hand = hands[index];
+            while (b.slots[hand].referenced.exchange(false, std::memory_order_relaxed))
+                hand = (hand + 1) % bucket_size;
+            chosen = hand;
+            hand = (hand + 1) % bucket_size;
+        }
+        write(b.slots[chosen], key, word.size(), romanization);
+        const std::uint64_t other_tags = tags[index].load(std::memory_order_relaxed) & ~(std::uint64_t(0xFFFF) << chosen * 16);
+        tags[index].store(other_tags | tag << chosen * 16, std::memory_order_relaxed);
+        return out + romanization.size();
+    }
+};
+namespace {
+/**
+ * @return Whether a string of at least 3 bytes starts with a Hangul character (U+AC00 to U+D7A3), which are EA B0 80 to ED 9E A3.
+ */
+bool is_hangul_character(const char* const p) {
+    const auto byte = [p](const int i) { return static_cast<unsigned char>(p[i]); };
+    if ((byte(0) & 0xF0) != 0xE0 || (byte(1) & 0xC0) != 0x80 || (byte(2) & 0xC0) != 0x80)
+        return false;
+    const unsigned code_point = (byte(0) & 0x0F) << 12 | (byte(1) & 0x3F) << 6 | (byte(2) & 0x3F);
+    return code_point - 0xAC00 < 11172;
+}
+}
+template <class System>
+basic_romanizer_cache<System>::basic_romanizer_cache(const std::size_t capacity, const std::size_t _shard_count)
+    : shards(new shard[std::max<std::size_t>(_shard_count, 1)]), shard_count(std::max<std::size_t>(_shard_count, 1)) {
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        shards[i].bucket_count = std::max<std::size_t>(capacity / shard_count / shard::bucket_size, 1);
+        shards[i].buckets.reset(new typename shard::bucket[shards[i].bucket_count]);
+        shards[i].tags.reset(new std::atomic<std::uint64_t>[shards[i].bucket_count]());
+        shards[i].hands.reset(new unsigned char[shards[i].bucket_count]());
+    }
+}
+template <class System>
+basic_romanizer_cache<System>::~basic_romanizer_cache() = default;
+template <class System>
+std::string basic_romanizer_cache<System>::romanize(const std::string_view s) {
+    std::string result;
+    romanize(s, result);
+    return result;
+}
+template <class System>
+void basic_romanizer_cache<System>::romanize(const std::string_view s, std::string& result) {
+    call_metrics metrics(s.size(), &result);
+    // a word is never romanized longer than on its own, so the romanization of the whole string fits,
+    // along with a whole romanization copied from a slot past the end of the last one
+    append(result, basic_romanizer<System>::max_romanized_size(s.size()) + shard::max_romanization_size, [&](char* out) {
+        const char* begin = s.data();
+        const char* const end = begin + s.size();
+        // the start of the characters that are not Hangul and have not been written yet
+        const char* copied = begin;
+        // the words found in the cache, and the shard the last of them was found in
+        std::uint64_t found = 0;
+        shard* found_in = nullptr;
+        while (begin != end) {
+            // words are usually separated by a single ASCII character, which is quicker to skip than to search past
+            if (static_cast<unsigned char>(*begin) < 0x80 && (++begin == end || static_cast<unsigned char>(*begin) < 0x80))
+                begin = basic_romanizer<System>::find_non_ascii(begin, end);
+            if (begin == end)
+                break;
+            const char* const word_begin = begin;
+            // a run of Hangul characters is only measured, unless it might contain conjoining jamo, which need the decoder to be composed
+            while (end - begin >= 3 && is_hangul_character(begin))
+                begin += 3;
+            if (begin != end && static_cast<unsigned char>(*begin) == 0xE1) {
+                begin = word_begin;
+                // preceded by the last character of the previous block, which a trailing consonant jamo might be added to
+                korean_character decoded[basic_romanizer<System>::hangul_block_size + 1];
+                while (basic_romanizer<System>::decode_syllables(begin, end, decoded + 1, basic_romanizer<System>::hangul_block_size, nullptr) == basic_romanizer<System>::hangul_block_size)
+                    decoded[0] = decoded[basic_romanizer<System>::hangul_block_size];
             }
-        // ㅂ
-        case 16:
-            switch (next_leading_consonant_index) {
-                case ㄴ:
-                case ㄹ:
-                case ㅁ: return "m";
-                case ㅃ:
-                case ㅇ:
-                case ㅎ: return "";
-                default: return pronunciations[index];
+            if (begin == word_begin) {
+                basic_romanizer<System>::decode_character(begin, end);
+                continue;
             }
-        // ㅄ
-        case 17:
-            switch (next_leading_consonant_index) {
-                case ㄴ:
-                case ㄹ:
-                case ㅁ: return "m";
-                case ㅃ: return "";
-                default: return pronunciations[index];
+            out = std::copy(copied, word_begin, out);
+            const std::string_view word(word_begin, begin - word_begin);
+            if (word.size() > max_word_size) {
+                out += basic_romanizer<System>::romanize(word, out);
+            } else {
+                // the key is copied as a whole and masked where the string goes on past the word, which avoids copying as many bytes as the word takes
+                std::uint64_t key[key_size];
+                if (static_cast<std::size_t>(end - word_begin) >= sizeof(key)) {
+                    // as many ones as a key has bytes, followed by as many zeros, so that the bytes of a key past its word are masked off in memory order
+                    static_assert(sizeof(key) == 32, "the mask needs as many ones as a key has bytes");
+                    static constexpr unsigned char mask_bytes[2 * sizeof(key)] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                                                                  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+                    std::memcpy(key, word.data(), sizeof(key));
+                    for (std::size_t i = 0; i < key_size; ++i) {
+                        std::uint64_t mask;
+                        std::memcpy(&mask, mask_bytes + sizeof(key) - word.size() + i * 8, 8);
+                        key[i] &= mask;
+                    }
+                } else {
+                    std::fill(std::begin(key), std::end(key), 0);
+                    std::memcpy(key, word.data(), word.size());
+                }
+                // mixes every atomic word of the key independently, which is much cheaper than hashing the word byte by byte
+                std::uint64_t hash = word.size();
+                constexpr std::uint64_t multipliers[key_size] = {0x9E3779B97F4A7C15, 0xC2B2AE3D27D4EB4F, 0x165667B19E3779F9, 0xD6E8FEB86659FD93};
+                for (std::size_t i = 0; i < key_size; ++i)
+                    hash += (key[i] ^ key[i] >> 29) * multipliers[i];
+                hash = (hash ^ hash >> 32) * 0x9E3779B97F4A7C15;
+                hash ^= hash >> 29;
+                shard& sh = shards[static_cast<std::size_t>((hash & 0xFFFFFFFF) * shard_count >> 32)];
+                const std::uint64_t found_before = found;
+                out = sh.romanize(word, key, hash, out, found);
+                if (found != found_before)
+                    found_in = &sh;
             }
-        // ㅅ, ㅆ, ㅈ, ㅊ
-        case 18:
-        case 19:
-        case 21:
-        case 22:
-            switch (next_leading_consonant_index) {
-                case ㄴ:
-                case ㅁ: return "n";
-                case ㄹ: return "l";
-                case ㄸ:
-                case ㅇ:
-                case ㅌ: return "";
-                default: return pronunciations[index];
+            copied = begin;
+        }
+        if (found)
+            found_in->hits.fetch_add(found, std::memory_order_relaxed);
+        return std::copy(copied, end, out);
+    });
+}
+template <class System>
+std::uint64_t basic_romanizer_cache<System>::hits() const {
+    std::uint64_t hits = 0;
+    for (std::size_t i = 0; i < shard_count; ++i)
+        hits += shards[i].hits.load(std::memory_order_relaxed);
+    return hits;
+}
+template <class System>
+std::uint64_t basic_romanizer_cache<System>::misses() const {
+    std::uint64_t misses = 0;
+    for (std::size_t i = 0; i < shard_count; ++i)
+        misses += shards[i].misses.load(std::memory_order_relaxed);
+    return misses;
+}
+template <class System>
+std::size_t basic_romanizer_cache<System>::size() const {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < shard_count; ++i)
+        size += shards[i].size.load(std::memory_order_relaxed);
+    return size;
+}
+template <class System>
+void basic_romanizer_cache<System>::clear() {
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        shard& sh = shards[i];
+        std::lock_guard lock(sh.mutex);
+        for (std::size_t j = 0; j < sh.bucket_count; ++j) {
+            for (typename shard::slot& s : sh.buckets[j].slots)
+                if (s.sizes.load(std::memory_order_relaxed))
+                    shard::write(s, {}, 0, {});
+            sh.tags[j].store(0, std::memory_order_relaxed);
+            sh.hands[j] = 0;
+        }
+        sh.size.store(0, std::memory_order_relaxed);
+    }
+}
+template <class System>
+basic_romanized_view<System>::iterator::iterator(const std::string_view s) : position(s.data()), end(s.data() + s.size()), finished(false) {
+    advance();
+}
+template <class System>
+void basic_romanized_view<System>::iterator::advance() {
+    const auto is_continuation = [](const char c) { return (static_cast<unsigned char>(c) & 0xC0) == 0x80; };
+    no_offsets offsets;
+    no_error_recovery errors;
+    piece_size = 0;
+    // a chunk can romanize into nothing, such as a single Hangul character waiting for the character following it
+    while (!piece_size && !finished) {
+        char* out = piece;
+        if (position == end) {
+            out = basic_romanizer<System>::finish(previous_character, pending_character, out, offsets);
+            finished = true;
+        } else {
+            // cut the chunk at the end of a character, and not between a leading consonant jamo and a vowel jamo composed with it;
+            // continuation bytes past the first three are invalid anyway, and are left for the romanization loop to throw on
+            const char* chunk_end = static_cast<std::size_t>(end - position) > chunk_size ? position + chunk_size : end;
+            for (int i = 0; i < 3 && chunk_end != end && is_continuation(*chunk_end); ++i)
+                ++chunk_end;
+            if (end - chunk_end >= 3 && chunk_end - position >= 3 && is_leading_consonant_jamo(chunk_end - 3) && is_vowel_jamo(chunk_end))
+                chunk_end += 3;
+            out = basic_romanizer<System>::romanize(position, chunk_end, out, previous_character, pending_character, offsets, no_dictionary(), errors);
+            position = chunk_end;
+        }
+        piece_size = out - piece;
+    }
+}
+template <class System>
+std::size_t basic_romanized_view<System>::size() const {
+    std::size_t size = 0;
+    for (const std::string_view piece : *this)
+        size += piece.size();
+    return size;
+}
+template <class System>
+std::uint64_t basic_romanized_view<System>::hash() const {
+    std::uint64_t hash = korean_romanization_hash({});
+    for (const std::string_view piece : *this)
+        hash = korean_romanization_hash(piece, hash);
+    return hash;
+}
+template <class System>
+int basic_romanized_view<System>::compare(std::string_view latin) const {
+    for (const std::string_view piece : *this) {
+        // a shorter rest of latin compares as less than the piece when it is a prefix of it
+        if (const int result = piece.compare(latin.substr(0, piece.size())))
+            return result;
+        latin.remove_prefix(piece.size());
+    }
+    return latin.empty() ? 0 : -1;
+}
+korean_romanizer_metrics::snapshot korean_romanizer_metrics::take_snapshot() {
+    snapshot result;
+#ifdef KOREAN_ROMANIZER_METRICS
+    std::uint64_t values[static_cast<std::size_t>(metric::count)] = {};
+    for (const metrics_block* block = metrics_blocks.load(std::memory_order_acquire); block; block = block->next) {
+        for (std::size_t i = 0; i < std::size(values); ++i)
+            values[i] += block->values[i].load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < latency_bucket_count; ++i)
+            result.latency_histogram[i] += block->latency_histogram[i].load(std::memory_order_relaxed);
+    }
+    const auto value = [&values](const metric m) { return values[static_cast<std::size_t>(m)]; };
+    result.calls = value(metric::calls);
+    result.failed_calls = value(metric::failed_calls);
+    result.input_bytes = value(metric::input_bytes);
+    result.output_bytes = value(metric::output_bytes);
+    result.result_allocations = value(metric::result_allocations);
+    result.hangul_characters = value(metric::hangul_characters);
+    result.other_code_points = value(metric::other_code_points);
+    result.invalid_sequences = value(metric::invalid_sequences);
+    result.changed_leading_consonants = value(metric::changed_leading_consonants);
+    result.changed_trailing_consonants = value(metric::changed_trailing_consonants);
+    result.cache_hits = value(metric::cache_hits);
+    result.cache_misses = value(metric::cache_misses);
+#endif
+    return result;
+}
+void korean_romanizer_metrics::set_latency_histogram([[maybe_unused]] const bool on) {
+#ifdef KOREAN_ROMANIZER_METRICS
+    latency_histogram_enabled.store(on, std::memory_order_relaxed);
+#endif
+}
+void korean_romanizer_offset_map::clear() {
+    segments.clear();
+    syllable_lengths.clear();
+    source_size = 0;
+    romanization_size = 0;
+    pending_source_size = 3;
+}
+void korean_romanizer_offset_map::record_copy(const std::size_t size) {
+    if (segments.empty() || segments.back().syllable_count)
+        segments.push_back({source_size, romanization_size, syllable_lengths.size(), 0});
+    source_size += size;
+    romanization_size += size;
+}
+void korean_romanizer_offset_map::record_syllable(const std::size_t size) {
+    if (segments.empty() || !segments.back().syllable_count || segments.back().syllable_count == max_segment_syllables)
+        segments.push_back({source_size, romanization_size, syllable_lengths.size(), 0});
+    ++segments.back().syllable_count;
+    syllable_lengths.push_back(static_cast<unsigned char>(size));
+    source_size += 3;
+    romanization_size += size;
+}
+std::size_t korean_romanizer_offset_map::to_romanization(const std::size_t source_offset) const {
+    if (source_offset >= source_size)
+        return romanization_size;
+    const segment& s = *(std::upper_bound(segments.begin(), segments.end(), source_offset, [](const std::size_t offset, const segment& s) {
+        return offset < s.source_offset;
+    }) - 1);
+    if (!s.syllable_count)
+        return s.romanization_offset + (source_offset - s.source_offset);
+    std::size_t romanization_offset = s.romanization_offset;
+    for (std::size_t i = 0; i < (source_offset - s.source_offset) / 3; ++i)
+        romanization_offset += syllable_lengths[s.first_syllable + i];
+    return romanization_offset;
+}
+std::size_t korean_romanizer_offset_map::to_source(const std::size_t romanization_offset) const {
+    if (romanization_offset >= romanization_size)
+        return source_size;
+    const segment& s = *(std::upper_bound(segments.begin(), segments.end(), romanization_offset, [](const std::size_t offset, const segment& s) {
+        return offset < s.romanization_offset;
+    }) - 1);
+    if (!s.syllable_count)
+        return s.source_offset + (romanization_offset - s.romanization_offset);
+    std::size_t end = s.romanization_offset;
+    std::size_t i = 0;
+    while ((end += syllable_lengths[s.first_syllable + i]) <= romanization_offset)
+        ++i;
+    return s.source_offset + i * 3;
+}
+namespace {
+/**
+ * Decodes a word into the symbols the trie of a @link korean_romanizer_dictionary @endlink is labeled with,
+ * which are the high and the low seven bits of the index of every Hangul character.
+ *
+ * @throws std::invalid_argument If the word is empty, too long or not made of Hangul characters.
+ */
+std::u16string decode_word(const std::string_view word) {
+    std::u16string symbols;
+    for (std::size_t i = 0; i < word.size(); i += 3) {
+        const auto byte = [&word, i](const std::size_t j) { return static_cast<unsigned char>(word[i + j]); };
+        if (word.size() - i < 3 || (byte(0) & 0xF0) != 0xE0 || (byte(1) & 0xC0) != 0x80 || (byte(2) & 0xC0) != 0x80)
+            throw std::invalid_argument("korean_romanizer_dictionary: \"" + std::string(word) + "\" is not a word of Hangul characters");
+        const korean_character c(static_cast<char32_t>((byte(0) & 0x0F) << 12 | (byte(1) & 0x3F) << 6 | (byte(2) & 0x3F)));
+        if (!c.is_korean_character())
+            throw std::invalid_argument("korean_romanizer_dictionary: \"" + std::string(word) + "\" is not a word of Hangul characters");
+        symbols += {static_cast<char16_t>(c.index() >> 7), static_cast<char16_t>(c.index() & 0x7F)};
+    }
+    if (symbols.empty() || symbols.size() / 2 > korean_romanizer_dictionary::max_word_syllables)
+        throw std::invalid_argument("korean_romanizer_dictionary: \"" + std::string(word) + "\" is empty or too long");
+    return symbols;
+}
+/**
+ * Reads a whole file into memory.
+ *
+ * @throws std::runtime_error If the file cannot be read.
+ */
+std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::string contents;
+    if (file)
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (!file && !file.eof())
+        throw std::runtime_error("korean_romanizer_dictionary: cannot read " + path);
+    return contents;
+}
+/**
+ * Allocates an image of a @link korean_romanizer_dictionary @endlink, on huge pages where the system has them if it is large,
+ * since lookups in a large dictionary land all over its filters and trie and would otherwise miss the TLB on most of them.
+ */
+std::shared_ptr<char> allocate_image(const std::size_t size) {
+#if defined(KOREAN_ROMANIZER_MMAP) && defined(MADV_HUGEPAGE)
+    constexpr std::size_t huge_page_size = 2 << 20;
+    if (size >= huge_page_size) {
+        constexpr std::align_val_t alignment{huge_page_size};
+        const std::size_t padded_size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+        char* const p = static_cast<char*>(::operator new(padded_size, alignment));
+        // only a hint, which is ignored where transparent huge pages are disabled
+        madvise(p, padded_size, MADV_HUGEPAGE);
+        return std::shared_ptr<char>(p, [alignment](char* const p) { ::operator delete(p, alignment); });
+    }
+#endif
+    constexpr std::align_val_t alignment{64};
+    return std::shared_ptr<char>(static_cast<char*>(::operator new(size, alignment)), [alignment](char* const p) { ::operator delete(p, alignment); });
+}
+}
+korean_romanizer_dictionary::korean_romanizer_dictionary() : korean_romanizer_dictionary(nullptr, 0) {}
+korean_romanizer_dictionary::korean_romanizer_dictionary(const std::pair<std::string_view, std::string_view>* const words, const std::size_t count) {
+    std::vector<std::pair<std::u16string, std::string_view>> sorted;
+    sorted.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (words[i].second.size() > max_romanization_size)
+            throw std::invalid_argument("korean_romanizer_dictionary: the romanization of \"" + std::string(words[i].first) + "\" is too long");
+        sorted.emplace_back(decode_word(words[i].first), words[i].second);
+    }
+    // of the romanizations of the same word, only the last one is kept
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::size_t unique_count = 0;
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        if (i + 1 != sorted.size() && sorted[i].first == sorted[i + 1].first)
+            continue;
+        if (unique_count != i)
+            sorted[unique_count] = std::move(sorted[i]);
+        ++unique_count;
+    }
+    sorted.resize(unique_count);
+
+    // the root never counts as free, nor as the parent of a cell
+    constexpr cell free_cell{0, -1, -1};
+    std::vector<cell> trie(1, cell{0, -2, -1});
+    // the words below a node, which all start with the same characters
+    struct subtree {
+        std::size_t node;
+        std::size_t begin;
+        std::size_t end;
+        std::size_t depth;
+    };
+    std::vector<subtree> pending{{0, 0, sorted.size(), 0}};
+    std::vector<std::pair<std::size_t, std::size_t>> children;
+    std::size_t first_free = 1;
+    while (!pending.empty()) {
+        subtree t = pending.back();
+        pending.pop_back();
+        if (t.begin != t.end && sorted[t.begin].first.size() == t.depth)
+            trie[t.node].value = static_cast<std::int32_t>(t.begin++);
+        if (t.begin == t.end)
+            continue;
+        // the symbol of every child, and where its words start
+        children.clear();
+        for (std::size_t i = t.begin; i < t.end; ++i)
+            if (children.empty() || sorted[i].first[t.depth] != children.back().first)
+                children.emplace_back(sorted[i].first[t.depth], i);
+        // find the first base at which every child lands on a free cell
+        std::size_t position = std::max(children.front().first + 1, first_free) - 1;
+        std::size_t taken = 0;
+        bool found_free = false;
+        std::size_t base;
+        for (;;) {
+            if (++position >= trie.size())
+                trie.resize(position + 1, free_cell);
+            if (trie[position].check != -1) {
+                ++taken;
+                continue;
             }
-        // ㅋ
-        case 23:
-            switch (next_leading_consonant_index) {
-                case ㄲ:
-                case ㅇ: return "";
-                case ㄴ:
-                case ㅁ:
-                case ㄹ: return "ng";
-                default: return pronunciations[index];
+            if (!found_free) {
+                first_free = position;
+                found_free = true;
             }
-        // ㅌ
-        case 24:
-            switch (next_leading_consonant_index) {
-                case ㄴ:
-                case ㅁ: return "n";
-                case ㄸ:
-                case ㅇ:
-                case ㅎ: return "";
-                case ㄹ: return "l";
-                default: return pronunciations[index];
+            base = position - children.front().first;
+            if (base + children.back().first >= trie.size())
+                trie.resize(base + children.back().first + 1, free_cell);
+            if (std::all_of(children.begin(), children.end(), [&](const auto& child) { return trie[base + child.first].check == -1; }))
+                break;
+        }
+        // once nearly every cell before the base is taken, later searches skip them
+        if (taken * 20 >= (position - first_free + 1) * 19)
+            first_free = position;
+        if (trie.size() > static_cast<std::size_t>(INT32_MAX))
+            throw std::length_error("korean_romanizer_dictionary: too many words");
+        trie[t.node].base = static_cast<std::int32_t>(base);
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            trie[base + children[i].first].check = static_cast<std::int32_t>(t.node);
+            pending.push_back({base + children[i].first, children[i].second, i + 1 < children.size() ? children[i + 1].second : t.end, t.depth + 1});
+        }
+    }
+
+    header h{};
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.byte_order = byte_order_mark;
+    h.cell_count = trie.size();
+    h.word_count = sorted.size();
+    h.min_word_syllables = max_word_syllables + 1;
+    for (const auto& [word, romanization] : sorted) {
+        h.min_word_syllables = std::min<std::uint64_t>(h.min_word_syllables, word.size() / 2);
+        h.romanizations_size += romanization.size();
+        h.max_length_per_syllable = std::max<std::uint32_t>(h.max_length_per_syllable, static_cast<std::uint32_t>((romanization.size() + word.size() / 2 - 1) / (word.size() / 2)));
+    }
+    if (h.romanizations_size > UINT32_MAX)
+        throw std::length_error("korean_romanizer_dictionary: too many words");
+
+    // about 16 bits of the pair filter for every word, which lets through about one in two hundred pairs that are not in the dictionary
+    h.pair_filter_size = 2;
+    unsigned shift = 63;
+    while (h.pair_filter_size * 4 < sorted.size()) {
+        h.pair_filter_size *= 2;
+        --shift;
+    }
+    std::vector<std::uint64_t> filters(single_character_filter_size + h.pair_filter_size);
+    // the filters are keyed on the packed jamo of the characters, which the romanizer decodes them into
+    const auto jamo = [](const char16_t high, const char16_t low) -> unsigned { return korean_character(korean_character::character_min + (high << 7 | low)).jamo; };
+    for (const auto& word : sorted) {
+        const unsigned first = jamo(word.first[0], word.first[1]);
+        if (word.first.size() == 2) {
+            filters[first >> 6] |= std::uint64_t{1} << (first & 63);
+        } else {
+            const unsigned second = jamo(word.first[2], word.first[3]);
+            filters[single_character_filter_size + pair_filter_word(first, second, shift)] |= pair_filter_mask(first, second);
+        }
+    }
+
+    const std::size_t size = sizeof(header) + filters.size() * sizeof(std::uint64_t) + trie.size() * sizeof(cell)
+        + (sorted.size() + 1) * sizeof(std::uint32_t) + h.romanizations_size;
+    const std::shared_ptr<char> data = allocate_image(size);
+    char* out = data.get();
+    std::memcpy(out, &h, sizeof(header));
+    std::memcpy(out += sizeof(header), filters.data(), filters.size() * sizeof(std::uint64_t));
+    std::memcpy(out += filters.size() * sizeof(std::uint64_t), trie.data(), trie.size() * sizeof(cell));
+    out += trie.size() * sizeof(cell);
+    std::uint32_t offset = 0;
+    for (const auto& word : sorted) {
+        std::memcpy(out, &offset, sizeof(offset));
+        out += sizeof(offset);
+        offset += static_cast<std::uint32_t>(word.second.size());
+    }
+    std::memcpy(out, &offset, sizeof(offset));
+    out += sizeof(offset);
+    for (const auto& word : sorted) {
+        std::memcpy(out, word.second.data(), word.second.size());
+        out += word.second.size();
+    }
+    attach(data, size);
+}
+void korean_romanizer_dictionary::attach(std::shared_ptr<const char> _image, const std::size_t size) {
+    const auto not_an_image = [] { return std::runtime_error("korean_romanizer_dictionary: not a dictionary image"); };
+    header h;
+    if (size < sizeof(header))
+        throw not_an_image();
+    std::memcpy(&h, _image.get(), sizeof(header));
+    if (std::memcmp(h.magic, magic, sizeof(magic)) != 0 || h.byte_order != byte_order_mark)
+        throw not_an_image();
+    // bounding every count by the size first keeps the sum below from overflowing
+    if (h.pair_filter_size < 2 || (h.pair_filter_size & (h.pair_filter_size - 1)) != 0 || h.pair_filter_size > size / sizeof(std::uint64_t)
+        || h.min_word_syllables == 0 || h.cell_count == 0 || h.cell_count > size / sizeof(cell) || h.word_count >= size / sizeof(std::uint32_t) || h.romanizations_size > size
+        || sizeof(header) + (single_character_filter_size + h.pair_filter_size) * sizeof(std::uint64_t) + h.cell_count * sizeof(cell)
+            + (h.word_count + 1) * sizeof(std::uint32_t) + h.romanizations_size != size)
+        throw not_an_image();
+    const char* const data = _image.get();
+    single_character_filter = reinterpret_cast<const std::uint64_t*>(data + sizeof(header));
+    pair_filter = single_character_filter + single_character_filter_size;
+    cells = reinterpret_cast<const cell*>(pair_filter + h.pair_filter_size);
+    romanization_offsets = reinterpret_cast<const std::uint32_t*>(cells + h.cell_count);
+    if (romanization_offsets[h.word_count] != h.romanizations_size)
+        throw not_an_image();
+    romanizations = reinterpret_cast<const char*>(romanization_offsets + h.word_count + 1);
+    pair_filter_shift = 63;
+    for (std::uint64_t words = h.pair_filter_size; words > 2; words /= 2)
+        --pair_filter_shift;
+    cell_count = h.cell_count;
+    word_count = h.word_count;
+    max_length_per_syllable = h.max_length_per_syllable;
+    min_word_syllables = h.min_word_syllables;
+    image = std::move(_image);
+    image_size = size;
+}
+korean_romanizer_dictionary korean_romanizer_dictionary::parse(const std::string_view text) {
+    std::vector<std::pair<std::string_view, std::string_view>> words;
+    std::size_t line_number = 0;
+    for (std::size_t begin = 0; begin < text.size();) {
+        const std::size_t end = std::min(text.find('\n', begin), text.size());
+        std::string_view line = text.substr(begin, end - begin);
+        begin = end + 1;
+        ++line_number;
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        const std::size_t word_begin = line.find_first_not_of(" \t");
+        if (word_begin == std::string_view::npos || line[word_begin] == '#')
+            continue;
+        const std::size_t word_end = line.find_first_of(" \t", word_begin);
+        const std::size_t romanization_begin = word_end == std::string_view::npos ? word_end : line.find_first_not_of(" \t", word_end);
+        if (romanization_begin == std::string_view::npos)
+            throw std::invalid_argument("korean_romanizer_dictionary: line " + std::to_string(line_number) + " has no romanization");
+        const std::size_t romanization_end = line.find_last_not_of(" \t") + 1;
+        words.emplace_back(line.substr(word_begin, word_end - word_begin), line.substr(romanization_begin, romanization_end - romanization_begin));
+    }
+    return korean_romanizer_dictionary(words.data(), words.size());
+}
+korean_romanizer_dictionary korean_romanizer_dictionary::load_text(const std::string& path) {
+    return parse(read_file(path));
+}
+korean_romanizer_dictionary korean_romanizer_dictionary::load(const std::string& path) {
+    korean_romanizer_dictionary dictionary;
+#ifdef KOREAN_ROMANIZER_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("korean_romanizer_dictionary: cannot read " + path + ": " + std::strerror(errno));
+    struct stat status{};
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+        mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("korean_romanizer_dictionary: cannot map " + path);
+    const auto size = static_cast<std::size_t>(status.st_size);
+    dictionary.attach(std::shared_ptr<const char>(static_cast<const char*>(mapping), [size](const char* const p) { munmap(const_cast<char*>(p), size); }), size);
+#else
+    const std::string contents = read_file(path);
+    const std::shared_ptr<char> data = allocate_image(contents.size());
+    std::memcpy(data.get(), contents.data(), contents.size());
+    dictionary.attach(data, contents.size());
+#endif
+    return dictionary;
+}
+void korean_romanizer_dictionary::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(image.get(), static_cast<std::streamsize>(image_size));
+    file.close();
+    if (!file)
+        throw std::runtime_error("korean_romanizer_dictionary: cannot write " + path);
+}
+namespace {
+/**
+ * The costs of the jamo of a parse in @link basic_deromanizer @endlink, which are lower for the jamo that are more common in Korean words,
+ * so that plain consonants come before tense and aspirated ones, and simple vowels and trailing consonants before compound ones.
+ */
+constexpr unsigned char leading_consonant_costs[19] = {0, 3, 0, 0, 3, 1, 0, 0, 3, 0, 3, 0, 0, 3, 2, 2, 2, 2, 0};
+constexpr unsigned char vowel_costs[21] = {0, 1, 1, 3, 0, 1, 1, 2, 0, 1, 3, 2, 1, 0, 2, 3, 2, 1, 0, 1, 0};
+constexpr unsigned char trailing_consonant_costs[28] = {0, 1, 3, 4, 1, 4, 4, 3, 1, 4, 4, 4, 5, 5, 5, 4, 1, 2, 4, 2, 2, 1, 3, 3, 4, 3, 3, 3};
+/**
+ * The cost of every character of a parse, so that parses into fewer characters come first.
+ */
+constexpr unsigned syllable_cost = 4;
+/**
+ * The cost of a character without a leading consonant after one with a trailing consonant, whose boundary is ambiguous unless written with a separator,
+ * such as 항욱 for <code>hanguk</code>, which is more likely to be 한국.
+ */
+constexpr unsigned unmarked_boundary_cost = 1;
+/**
+ * The cost of a separator that is not at the boundary between two characters.
+ */
+constexpr unsigned separator_cost = 4;
+/**
+ * The byte a run of separators is folded into before a query is parsed.
+ */
+constexpr char folded_separator = ' ';
+bool test_bit(const std::array<std::uint64_t, 4>& bits, const unsigned char c) {
+    return bits[c >> 6] >> (c & 63) & 1;
+}
+void set_bit(std::array<std::uint64_t, 4>& bits, const unsigned char c) {
+    bits[c >> 6] |= std::uint64_t(1) << (c & 63);
+}
+}
+template <class System>
+basic_deromanizer<System>::basic_deromanizer() : roots{}, next_bytes{}, separators{} {
+    using table = korean_character::pronunciation_table<System>;
+    const auto romanization = [](const typename table::entry e) { return table::blob.substr(e.offset, e.length); };
+    // built with a list of children per node, then flattened so that the children of every node are contiguous
+    struct building_node {
+        std::vector<std::pair<char, std::uint32_t>> children;
+        std::uint32_t boundary = no_node;
+        std::vector<std::uint16_t> values;
+    };
+    std::vector<building_node> building(29);
+    const auto insert = [&building](std::uint32_t n, const std::string_view s) {
+        for (const char c : s) {
+            const auto found = std::find_if(building[n].children.begin(), building[n].children.end(), [c](const auto& child) { return child.first == c; });
+            if (found != building[n].children.end()) {
+                n = found->second;
+                continue;
             }
-        // ㅍ
-        case 25:
-            switch (next_leading_consonant_index) {
-                case ㅃ:
-                case ㅇ: return "";
-                default: return pronunciations[index];
+            const auto child = static_cast<std::uint32_t>(building.size());
+            building[n].children.emplace_back(c, child);
+            building.emplace_back();
+            n = child;
+        }
+        return n;
+    };
+    for (std::uint32_t previous = 0; previous < 29; ++previous) {
+        roots[previous] = previous;
+        for (int leading = 0; leading < 19; ++leading) {
+            std::uint32_t n = insert(previous, romanization(table::trailing_consonants[previous % 28][leading]));
+            if (building[n].boundary == no_node) {
+                building[n].boundary = static_cast<std::uint32_t>(building.size());
+                building.emplace_back();
             }
-        // ㅎ
-        case 26:
-            switch (next_leading_consonant_index) {
-                case ㄱ:
-                case ㄲ:
-                case ㄷ:
-                case ㄸ:
-                case ㅇ:
-                case ㅈ:
-                case ㅉ:
-                case ㅊ:
-                case ㅋ:
-                case ㅌ:
-                case ㅍ:
-                case ㅎ: return "";
-                case ㄴ:
-                case ㅁ:
-                case ㄹ: return "n";
-                default: return pronunciations[index];
+            n = insert(building[n].boundary, romanization(table::leading_consonants[previous][leading]));
+            for (int vowel = 0; vowel < 21; ++vowel)
+                building[insert(n, romanization(table::vowels[vowel]))].values.push_back(static_cast<std::uint16_t>(leading << 5 | vowel));
+        }
+    }
+    nodes.reserve(building.size());
+    for (const building_node& b : building) {
+        nodes.push_back(node{static_cast<std::uint32_t>(edges.size()), static_cast<std::uint32_t>(b.children.size()), b.boundary,
+                             static_cast<std::uint32_t>(values.size()), static_cast<std::uint32_t>(b.values.size())});
+        for (const auto& [label, target] : b.children)
+            edges.push_back(edge{label, target});
+        values.insert(values.end(), b.values.begin(), b.values.end());
+    }
+    for (const char c : std::string_view(" -_'"))
+        if (table::blob.find(c) == std::string_view::npos)
+            set_bit(separators, c);
+    set_bit(separators, folded_separator);
+    for (std::size_t previous = 0; previous < 29; ++previous) {
+        const node& root = nodes[roots[previous]];
+        for (std::uint32_t i = 0; i < root.edge_count; ++i)
+            set_bit(next_bytes[previous], edges[root.first_edge + i].label);
+        if (root.boundary != no_node) {
+            const node& boundary = nodes[root.boundary];
+            for (std::uint32_t i = 0; i < boundary.edge_count; ++i)
+                set_bit(next_bytes[previous], edges[boundary.first_edge + i].label);
+        }
+        for (const korean_spelling_variant& variant : System::spelling_variants)
+            set_bit(next_bytes[previous], variant.written[0]);
+        set_bit(next_bytes[previous], folded_separator);
+    }
+}
+template <class System>
+template <class Function>
+void basic_deromanizer<System>::walk(const std::string_view query, const std::uint32_t* const variants, const std::size_t position, const std::uint32_t n,
+                                     const unsigned cost, Function& f) const {
+    const auto child = [this](const std::uint32_t parent, const char c) {
+        const node& p = nodes[parent];
+        for (std::uint32_t i = 0; i < p.edge_count; ++i)
+            if (edges[p.first_edge + i].label == c)
+                return edges[p.first_edge + i].target;
+        return no_node;
+    };
+    const node& current = nodes[n];
+    if (current.value_count)
+        f(n, position, cost);
+    if (current.boundary != no_node) {
+        walk(query, variants, position, current.boundary, cost, f);
+        if (position < query.size() && query[position] == folded_separator)
+            walk(query, variants, position + 1, current.boundary, cost, f);
+    }
+    if (position == query.size())
+        return;
+    if (const std::uint32_t next = child(n, query[position]); next != no_node)
+        walk(query, variants, position + 1, next, cost, f);
+    if (query[position] == folded_separator)
+        walk(query, variants, position + 1, n, cost + separator_cost, f);
+    for (std::size_t i = 0; variants[position] >> i; ++i) {
+        if (!(variants[position] >> i & 1))
+            continue;
+        const korean_spelling_variant& variant = System::spelling_variants[i];
+        std::uint32_t next = n;
+        for (std::size_t i = 0; i < variant.romanized.size() && next != no_node; ++i)
+            next = child(next, variant.romanized[i]);
+        if (next != no_node)
+            walk(query, variants, position + variant.written.size(), next, cost + variant.cost, f);
+    }
+}
+template <class System>
+std::vector<typename basic_deromanizer<System>::candidate> basic_deromanizer<System>::candidates(const std::string_view latin, const std::size_t max_candidates) const {
+    std::vector<candidate> result;
+    candidates(latin, max_candidates, result);
+    return result;
+}
+template <class System>
+void basic_deromanizer<System>::candidates(const std::string_view latin, const std::size_t max_candidates, std::vector<candidate>& result) const {
+    using table = korean_character::pronunciation_table<System>;
+    result.clear();
+    if (!max_candidates || latin.size() > max_query_size)
+        return;
+    std::string query;
+    query.reserve(latin.size());
+    for (std::size_t i = 0; i < latin.size(); ++i) {
+        auto c = static_cast<unsigned char>(latin[i]);
+        if (test_bit(separators, c)) {
+            if (!query.empty() && query.back() != folded_separator)
+                query += folded_separator;
+            continue;
+        }
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        } else if (c == 0xC5 && i + 1 < latin.size() && (latin[i + 1] == '\x8E' || latin[i + 1] == '\xAC')) {
+            // Ŏ and Ŭ, whose lowercase forms follow them
+            query += static_cast<char>(c);
+            c = static_cast<unsigned char>(latin[++i]) + 1;
+        }
+        query += static_cast<char>(c);
+    }
+    if (!query.empty() && query.back() == folded_separator)
+        query.pop_back();
+    if (query.empty())
+        return;
+    const auto ends_with_trailing_consonant = [&query](const std::size_t trailing, const std::size_t position) {
+        const typename table::entry e = table::trailing_consonants[trailing][19];
+        return query.compare(position, std::string_view::npos, table::blob.substr(e.offset, e.length)) == 0;
+    };
+    // the informal spellings the query continues with at every position, and the trailing consonants it can continue after, as bit sets
+    static_assert(std::size(System::spelling_variants) <= 32, "too many spelling variants");
+    std::vector<std::uint32_t> variants(query.size() + 1), viable_trailing_consonants(query.size() + 1);
+    for (std::size_t position = 0; position <= query.size(); ++position) {
+        for (std::size_t i = 0; i < std::size(System::spelling_variants); ++i)
+            if (query.compare(position, System::spelling_variants[i].written.size(), System::spelling_variants[i].written) == 0)
+                variants[position] |= std::uint32_t(1) << i;
+        for (std::size_t trailing = 0; trailing < 28; ++trailing)
+            if ((position < query.size() && test_bit(next_bytes[trailing], query[position])) || ends_with_trailing_consonant(trailing, position))
+                viable_trailing_consonants[position] |= std::uint32_t(1) << trailing;
+    }
+
+    // the cheapest parses reaching every position with every trailing consonant, cheapest first,
+    // each pointing at the parse it extends so that the parses share their prefixes
+    struct parse {
+        unsigned cost;
+        std::uint32_t parent;
+        std::uint16_t syllable;
+    };
+    constexpr std::uint32_t no_parse = ~std::uint32_t(0);
+    const std::size_t width = std::min(max_candidates, max_beam_width);
+    const std::size_t state_count = (query.size() + 1) * 29;
+    // reused by every query on the thread, unless a long query or a wide beam has made it larger than max_retained_parses
+    thread_local std::vector<parse> scratch;
+    std::vector<parse>& parses = scratch;
+    parses.resize(state_count * width);
+    std::vector<std::uint32_t> counts(state_count);
+    parses[28 * width] = parse{0, no_parse, 0};
+    counts[28] = 1;
+    const auto insert = [&parses, &counts, width](const std::size_t state, const parse p) {
+        parse* const begin = &parses[state * width];
+        std::uint32_t& count = counts[state];
+        if (count == width) {
+            if (p.cost >= begin[width - 1].cost)
+                return false;
+            --count;
+        }
+        std::size_t i = count++;
+        for (; i && begin[i - 1].cost > p.cost; --i)
+            begin[i] = begin[i - 1];
+        begin[i] = p;
+        return true;
+    };
+    struct hit {
+        std::uint32_t node;
+        std::uint32_t position;
+        unsigned cost;
+    };
+    std::vector<hit> hits;
+    auto collect = [&hits](const std::uint32_t n, const std::size_t position, const unsigned cost) {
+        hits.push_back(hit{n, static_cast<std::uint32_t>(position), cost});
+    };
+    for (std::size_t position = 0; position < query.size(); ++position) {
+        for (std::size_t previous = 0; previous < 29; ++previous) {
+            const std::size_t state = position * 29 + previous;
+            if (!counts[state])
+                continue;
+            hits.clear();
+            walk(query, variants.data(), position, roots[previous], 0, collect);
+            // a node can be reached in more than one way, of which only the cheapest is kept
+            std::sort(hits.begin(), hits.end(), [](const hit& a, const hit& b) {
+                return a.position != b.position ? a.position < b.position : a.node != b.node ? a.node < b.node : a.cost < b.cost;
+            });
+            hits.erase(std::unique(hits.begin(), hits.end(), [](const hit& a, const hit& b) { return a.position == b.position && a.node == b.node; }), hits.end());
+            for (const hit& h : hits) {
+                const node& n = nodes[h.node];
+                for (std::uint32_t v = n.first_value; v < n.first_value + n.value_count; ++v) {
+                    const unsigned leading = values[v] >> 5, vowel = values[v] & 0x1F;
+                    const unsigned cost = h.cost + syllable_cost + leading_consonant_costs[leading] + vowel_costs[vowel]
+                        + (leading == 11 && previous && previous < 28 ? unmarked_boundary_cost : 0);
+                    // only the trailing consonants the rest of the query can continue after
+                    for (unsigned trailing = 0; viable_trailing_consonants[h.position] >> trailing; ++trailing) {
+                        if (!(viable_trailing_consonants[h.position] >> trailing & 1))
+                            continue;
+                        const std::size_t target = h.position * 29 + trailing;
+                        const auto syllable = static_cast<std::uint16_t>((leading * 21 + vowel) * 28 + trailing);
+                        for (std::uint32_t i = 0; i < counts[state]; ++i) {
+                            const std::uint32_t slot = static_cast<std::uint32_t>(state * width + i);
+                            if (!insert(target, parse{parses[slot].cost + cost + trailing_consonant_costs[trailing], slot, syllable}))
+                                break;
+                        }
+                    }
+                }
             }
-        default: return pronunciations[index];
-    }
-}
-korean_character::korean_character() { is_empty = true; }
-korean_character::korean_character(const wchar_t _c) : c(_c) { decompose_character(c); }
-void korean_character::decompose_character(const wchar_t _c) {
-    const int i = _c - character_min;
-    if (i < 0 || i >= all_jamo_combination_count)
-        is_korean_character = false;
-    std::string s;
-    leading_consonant = leading_consonant_jamo_min + i / vowel_and_trailing_consonant_jamo_combination_count;
-    vowel = vowel_jamo_min + i % vowel_and_trailing_consonant_jamo_combination_count / trailing_consonant_jamo_count;
-    if (const int _trailing_consonant = trailing_consonant_jamo_min + i % trailing_consonant_jamo_count;
-        _trailing_consonant != trailing_consonant_jamo_min)
-        trailing_consonant = _trailing_consonant;
-    else
-        trailing_consonant = 0;
-}
-std::string korean_character::romanize_character(const korean_character& previous_character, const korean_character& next_character) {
-    std::string result;
-    if (!is_korean_character) {
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-        return converter.to_bytes({1, c});
-    }
-    const int leading_consonant_index = leading_consonant - leading_consonant_jamo_min;
-    const int vowel_index = vowel - vowel_jamo_min;
-    const int trailing_consonant_index = trailing_consonant - (trailing_consonant_jamo_min + 1);
-    int previous_trailing_consonant_index;
-    if (!previous_character.is_empty)
-        previous_trailing_consonant_index = previous_character.trailing_consonant - (trailing_consonant_jamo_min + 1);
-    else
-        previous_trailing_consonant_index = -1;
-    int next_leading_consonant_index;
-    if (!next_character.is_empty)
-        next_leading_consonant_index = next_character.leading_consonant - leading_consonant_jamo_min;
-    else
-        next_leading_consonant_index = -1;
-    result += leading_consonant_pronunciation::get_pronunciation(previous_trailing_consonant_index, leading_consonant_index);
-    result += vowel_pronunciation::get_pronunciation(vowel_index);
-    result += trailing_consonant_pronunciation::get_pronunciation(next_leading_consonant_index, trailing_consonant_index);
+        }
+    }
+
+    std::vector<std::pair<unsigned, std::uint32_t>> complete;
+    for (std::size_t position = 1; position <= query.size(); ++position)
+        for (std::size_t trailing = 0; trailing < 28; ++trailing)
+            if (counts[position * 29 + trailing] && ends_with_trailing_consonant(trailing, position))
+                for (std::uint32_t i = 0; i < counts[position * 29 + trailing]; ++i) {
+                    const auto slot = static_cast<std::uint32_t>((position * 29 + trailing) * width + i);
+                    complete.emplace_back(parses[slot].cost, slot);
+                }
+    std::stable_sort(complete.begin(), complete.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<std::uint16_t> syllables;
+    for (const auto& [cost, last] : complete) {
+        if (result.size() == width)
+            break;
+        syllables.clear();
+        for (std::uint32_t slot = last; parses[slot].parent != no_parse; slot = parses[slot].parent)
+            syllables.push_back(parses[slot].syllable);
+        std::string hangul;
+        hangul.reserve(syllables.size() * 3);
+        for (auto s = syllables.rbegin(); s != syllables.rend(); ++s) {
+            const char32_t c = 0xAC00 + *s;
+            hangul += static_cast<char>(0xE0 | c >> 12);
+            hangul += static_cast<char>(0x80 | (c >> 6 & 0x3F));
+            hangul += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        // different parses, such as with and without an informal spelling, can yield the same string
+        if (std::none_of(result.begin(), result.end(), [&hangul](const candidate& c) { return c.hangul == hangul; }))
+            result.push_back(candidate{std::move(hangul), cost});
+    }
+    if (parses.capacity() > max_retained_parses) {
+        parses.clear();
+        parses.shrink_to_fit();
+    }
+}
+namespace {
+/**
+ * The cost of romanizing a trailing consonant and the leading consonant following it as if they did not affect each other,
+ * such as <code>sinra</code> for 신라.
+ */
+constexpr unsigned unassimilated_cost = 3;
+/**
+ * The cost of pronouncing a ㄹ following ㄴ as ㄴ, as in 신문로 (<code>sinmunno</code>), rather than the ㄴ as ㄹ, as in 난로 (<code>nallo</code>).
+ */
+constexpr unsigned nasalized_cost = 2;
+/**
+ * @brief One way to write a piece of a romanization in @link basic_romanization_fingerprinter @endlink: a trailing consonant
+ * together with the leading consonant following it, which affect each other, a vowel, or a run of text that is not Hangul.
+ */
+struct fingerprint_alternative {
+    std::string_view text[2];
+    unsigned cost;
+    /**
+     * Returns whether two alternatives write the same text, even if split differently.
+     */
+    bool writes_same_text(const fingerprint_alternative& other) const {
+        if (text[0].size() + text[1].size() != other.text[0].size() + other.text[1].size())
+            return false;
+        const auto at = [](const fingerprint_alternative& a, const std::size_t i) { return i < a.text[0].size() ? a.text[0][i] : a.text[1][i - a.text[0].size()]; };
+        for (std::size_t i = 0; i < text[0].size() + text[1].size(); ++i)
+            if (at(*this, i) != at(other, i))
+                return false;
+        return true;
+    }
+};
+}
+template <class System>
+basic_romanization_fingerprinter<System>::basic_romanization_fingerprinter() : leading_consonant_variants{}, vowel_variants{}, trailing_consonant_variants{} {
+    using table = korean_character::pronunciation_table<System>;
+    static_assert(std::size(System::spelling_variants) <= 32, "the informal spellings of a romanization are stored as a bit set");
+    const auto variants = [](const typename table::entry e) {
+        const std::string_view romanization = table::blob.substr(e.offset, e.length);
+        std::uint32_t bits = 0;
+        for (std::size_t i = 0; i < std::size(System::spelling_variants); ++i)
+            if (!romanization.empty() && System::spelling_variants[i].romanized == romanization)
+                bits |= std::uint32_t(1) << i;
+        return bits;
+    };
+    for (std::size_t previous = 0; previous < 29; ++previous)
+        for (std::size_t leading = 0; leading < 19; ++leading)
+            leading_consonant_variants[previous][leading] = variants(table::leading_consonants[previous][leading]);
+    for (std::size_t vowel = 0; vowel < 21; ++vowel)
+        vowel_variants[vowel] = variants(table::vowels[vowel]);
+    for (std::size_t trailing = 0; trailing < 28; ++trailing)
+        for (std::size_t next = 0; next < 20; ++next)
+            trailing_consonant_variants[trailing][next] = variants(table::trailing_consonants[trailing][next]);
+}
+template <class System>
+std::vector<std::uint64_t> basic_romanization_fingerprinter<System>::fingerprints(const std::string_view s, const std::size_t max_fingerprints, const unsigned max_cost) const {
+    std::vector<std::uint64_t> result;
+    fingerprints(s, max_fingerprints, max_cost, result);
     return result;
 }
-std::string korean_romanizer::romanize(const std::string& s) {
-    std::string result;
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    std::wstring w = converter.from_bytes(s);
-    const wchar_t *_w = w.c_str();
-    korean_character previous_character;
-    korean_character current_character = korean_character();
-    korean_character next_character;
-    for (int i = 0; i < w.size(); ++i) {
-        previous_character = current_character;
-        current_character = korean_character(_w[i]);
-        next_character = i < w.size() - 1 ? korean_character(_w[i + 1]) : korean_character();
-        if (current_character.is_korean_character)
-            result += current_character.romanize_character(previous_character, next_character);
+template <class System>
+void basic_romanization_fingerprinter<System>::fingerprints(const std::string_view s, const std::size_t max_fingerprints, const unsigned max_cost, std::vector<std::uint64_t>& result) const {
+    using table = korean_character::pronunciation_table<System>;
+    using romanizer = basic_romanizer<System>;
+    const auto romanization = [](const typename table::entry e) { return table::blob.substr(e.offset, e.length); };
+    result.clear();
+    if (!max_fingerprints)
+        return;
+    // the characters of the string, with every run of text that is not Hangul as a single character that is not Hangul,
+    // after a character that is not Hangul for decode_syllables to look back at
+    std::vector<korean_character> characters(1);
+    std::vector<std::string_view> others;
+    const char* begin = s.data();
+    const char* const end = begin + s.size();
+    while (begin != end) {
+        if (may_start_hangul(*begin)) {
+            const std::size_t size = characters.size();
+            characters.resize(size + romanizer::hangul_block_size);
+            const std::size_t decoded = romanizer::decode_syllables(begin, end, characters.data() + size, romanizer::hangul_block_size, nullptr);
+            characters.resize(size + decoded);
+            if (decoded)
+                continue;
+        }
+        const char* const other_begin = begin;
+        if (static_cast<unsigned char>(*begin) < 0x80)
+            begin = romanizer::find_non_ascii(begin, end);
         else
-            result += converter.to_bytes({1, current_character.c}).substr(1);
+            romanizer::decode_character(begin, end);
+        if (characters.size() > 1 && !characters.back().is_korean_character()) {
+            others.back() = std::string_view(others.back().data(), others.back().size() + (begin - other_begin));
+        } else {
+            characters.emplace_back();
+            others.emplace_back(other_begin, begin - other_begin);
+        }
     }
-    return result;
-}
\ No newline at end of file
+    // the alternatives of every piece of the romanization, from the first alternative of every slot to the end of the last one
+    std::vector<fingerprint_alternative> alternatives;
+    std::vector<std::uint32_t> slots;
+    const auto add = [&alternatives, &slots](const std::string_view first, const std::string_view second, const unsigned cost) {
+        const fingerprint_alternative alternative{{first, second}, cost};
+        for (auto a = alternatives.begin() + slots.back(); a != alternatives.end(); ++a) {
+            if (a->writes_same_text(alternative)) {
+                a->cost = std::min(a->cost, cost);
+                return;
+            }
+        }
+        alternatives.push_back(alternative);
+    };
+    // adds two pieces as written by the rules and in every combination of their informal spellings
+    const auto add_spellings = [&add](const std::string_view first, const std::uint32_t first_variants, const std::string_view second,
+                                      const std::uint32_t second_variants, const unsigned cost) {
+        const auto spelling = [](const std::string_view rules, const std::size_t i) {
+            return i ? std::pair(System::spelling_variants[i - 1].written, System::spelling_variants[i - 1].cost) : std::pair(rules, 0u);
+        };
+        for (std::uint64_t a = std::uint64_t(first_variants) << 1 | 1, i = 0; a; a >>= 1, ++i) {
+            if (!(a & 1))
+                continue;
+            for (std::uint64_t b = std::uint64_t(second_variants) << 1 | 1, j = 0; b; b >>= 1, ++j) {
+                if (b & 1) {
+                    const auto [first_text, first_cost] = spelling(first, i);
+                    const auto [second_text, second_cost] = spelling(second, j);
+                    add(first_text, second_text, cost + first_cost + second_cost);
+                }
+            }
+        }
+    };
+    std::size_t other = 0;
+    for (std::size_t i = 1; i < characters.size(); ++i) {
+        const korean_character previous = characters[i - 1], c = characters[i];
+        slots.push_back(static_cast<std::uint32_t>(alternatives.size()));
+        if (!c.is_korean_character()) {
+            add(others[other++], {}, 0);
+            continue;
+        }
+        const unsigned trailing = previous.trailing_consonant(), leading = c.leading_consonant(), vowel = c.vowel();
+        if (trailing < 28) {
+            add_spellings(romanization(table::trailing_consonants[trailing][leading]), trailing_consonant_variants[trailing][leading],
+                          romanization(table::leading_consonants[trailing][leading]), leading_consonant_variants[trailing][leading], 0);
+        } else {
+            add_spellings(romanization(table::leading_consonants[trailing][leading]), leading_consonant_variants[trailing][leading], {}, 0, 0);
+        }
+        if (trailing && trailing < 28) {
+            add_spellings(romanization(table::trailing_consonants[trailing][19]), trailing_consonant_variants[trailing][19],
+                          romanization(table::leading_consonants[0][leading]), leading_consonant_variants[0][leading], unassimilated_cost);
+            // ㄴ followed by ㄹ, pronounced as if followed by ㄴ
+            if (trailing == 4 && leading == 5)
+                add_spellings(romanization(table::trailing_consonants[trailing][2]), trailing_consonant_variants[trailing][2],
+                              romanization(table::leading_consonants[trailing][2]), leading_consonant_variants[trailing][2], nasalized_cost);
+        }
+        slots.push_back(static_cast<std::uint32_t>(alternatives.size()));
+        add_spellings(romanization(table::vowels[vowel]), vowel_variants[vowel], {}, 0, 0);
+        if (i + 1 == characters.size() || !characters[i + 1].is_korean_character()) {
+            slots.push_back(static_cast<std::uint32_t>(alternatives.size()));
+            add_spellings(romanization(table::trailing_consonants[c.trailing_consonant()][19]), trailing_consonant_variants[c.trailing_consonant()][19], {}, 0, 0);
+        }
+    }
+    const std::size_t slot_count = slots.size();
+    slots.push_back(static_cast<std::uint32_t>(alternatives.size()));
+    // the highest cost the slots from every slot on can add, so that variants that cannot reach a cost are not built
+    std::vector<unsigned> max_suffix_costs(slot_count + 1);
+    for (std::size_t i = slot_count; i--;) {
+        unsigned highest = 0;
+        for (std::uint32_t a = slots[i]; a < slots[i + 1]; ++a)
+            highest = std::max(highest, alternatives[a].cost);
+        max_suffix_costs[i] = max_suffix_costs[i + 1] + highest;
+    }
+    // the variants of every cost in turn, built one slot at a time, each one extending the hash of the prefix it shares with the others
+    struct frame {
+        std::uint64_t hash;
+        unsigned cost;
+        std::uint32_t next_alternative;
+    };
+    std::vector<frame> stack(slot_count + 1);
+    for (unsigned cost = 0; cost <= max_cost && cost <= max_suffix_costs[0]; ++cost) {
+        stack[0] = frame{korean_romanization_hash({}), 0, slots[0]};
+        std::size_t depth = 0;
+        for (;;) {
+            frame& current = stack[depth];
+            if (depth == slot_count) {
+                // different variants, such as with an informal spelling of either of two pieces, can write the same text
+                if (std::find(result.begin(), result.end(), current.hash) == result.end()) {
+                    result.push_back(current.hash);
+                    if (result.size() == max_fingerprints)
+                        return;
+                }
+            } else if (current.next_alternative != slots[depth + 1]) {
+                const fingerprint_alternative& a = alternatives[current.next_alternative++];
+                const unsigned variant_cost = current.cost + a.cost;
+                if (variant_cost <= cost && variant_cost + max_suffix_costs[depth + 1] >= cost) {
+                    stack[depth + 1] = frame{korean_romanization_hash(a.text[1], korean_romanization_hash(a.text[0], current.hash)), variant_cost, slots[depth + 1]};
+                    ++depth;
+                }
+                continue;
+            }
+            if (!depth)
+                break;
+            --depth;
+        }
+    }
+}
+template class basic_romanizer<revised_romanization>;
+template class basic_romanizer<mccune_reischauer>;
+template class basic_romanizer_stream<revised_romanization>;
+template class basic_romanizer_stream<mccune_reischauer>;
+template class basic_romanizer_batch<revised_romanization>;
+template class basic_romanizer_batch<mccune_reischauer>;
+template class basic_romanizer_cache<revised_romanization>;
+template class basic_romanizer_cache<mccune_reischauer>;
+template class basic_romanized_view<revised_romanization>;
+template class basic_romanized_view<mccune_reischauer>;
+template class basic_deromanizer<revised_romanization>;
+template class basic_deromanizer<mccune_reischauer>;
+template class basic_romanization_fingerprinter<revised_romanization>;
+template class basic_romanization_fingerprinter<mccune_reischauer>;
@@ -1,88 +1,188 @@
 #ifndef korean_romanizer_h
 #define korean_romanizer_h
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 /**
  * @brief Encapsulates a Hangul character, providing functionality for decomposition and romanization.
  */
 class korean_character {
-    friend class korean_romanizer;
+    template <class System>
+    friend class basic_romanizer;
+    template <class System>
+    friend class basic_deromanizer;
+    template <class System>
+    friend class basic_romanization_fingerprinter;
+    friend class korean_romanizer_dictionary;
     /**
      * The code point of the first Hangul jamo representing a leading consonant (ᄀ) in the Unicode character table.
      *
      * @see <a href="https://en.wikipedia.org/wiki/Hangul_Jamo_(Unicode_block)">Hangul Jamo (Unicode block) on Wikipedia</a>
      */
-    int leading_consonant_jamo_min = 0x1100;
+    static constexpr int leading_consonant_jamo_min = 0x1100;
     /**
      * The code point of the first Hangul jamo representing a vowel (ᅡ) in the Unicode character table.
      *
      * @see <a href="https://en.wikipedia.org/wiki/Hangul_Jamo_(Unicode_block)">Hangul Jamo (Unicode block) on Wikipedia</a>
      */
-    int vowel_jamo_min = 0x1161;
+    static constexpr int vowel_jamo_min = 0x1161;
     /**
      * One code point before the first Hangul jamo representing a trailing consonant (ᆨ) in the Unicode character table.
      * (Moving the code point accounts for the lack of a trailing consonant.)
      *
      * @see <a href="https://en.wikipedia.org/wiki/Hangul_Jamo_(Unicode_block)">Hangul Jamo (Unicode block) on Wikipedia</a>
      */
-    int trailing_consonant_jamo_min = 0x11A7;
+    static constexpr int trailing_consonant_jamo_min = 0x11A7;
     /**
      * The amount of Hangul jamo representing a leading consonant.
      */
-    int leading_consonant_jamo_count = 19;
+    static constexpr int leading_consonant_jamo_count = 19;
     /**
      * The amount of Hangul jamo representing a vowel.
      */
-    int vowel_jamo_count = 21;
+    static constexpr int vowel_jamo_count = 21;
     /**
      * The amount of Hangul jamo representing a trailing consonant, including the lack thereof.
      */
-    int trailing_consonant_jamo_count = 28;
+    static constexpr int trailing_consonant_jamo_count = 28;
     /**
      * The product of @link vowel_jamo_count @endlink and @link trailing_consonant_jamo_count @endlink.
      *
      * This value is used in the decomposition algorithm of @link decompose_character @endlink.
      */
-    int vowel_and_trailing_consonant_jamo_combination_count = vowel_jamo_count * trailing_consonant_jamo_count;
+    static constexpr int vowel_and_trailing_consonant_jamo_combination_count = vowel_jamo_count * trailing_consonant_jamo_count;
     /**
      * The product of @link leading_consonant_jamo_count @endlink and @link vowel_and_trailing_consonant_jamo_combination_count @endlink,
      * representing the total amount of Hangul jamo combinations.
      *
      * This value is used in the decomposition algorithm of @link decompose_character @endlink.
      */
-    int all_jamo_combination_count = leading_consonant_jamo_count * vowel_and_trailing_consonant_jamo_combination_count;
+    static constexpr int all_jamo_combination_count = leading_consonant_jamo_count * vowel_and_trailing_consonant_jamo_combination_count;
     /**
      * The code point of the first Hangul character (가) in the Unicode character table.
      *
      * @see <a href="https://en.wikipedia.org/wiki/Hangul_Syllables">Hangul Syllables on Wikipedia</a>
      */
-    int character_min = 0xAC00;
+    static constexpr int character_min = 0xAC00;
     /**
-     * The leading consonant of this @link korean_character @endlink instance.
+     * The value of @link jamo @endlink for characters that are not Hangul.
+     *
+     * Its leading and trailing consonant indices are one past the last leading and trailing consonant,
+     * so that it can be used as a neighbor in @link romanize_character @endlink, where it selects the romanizations
+     * of a Hangul character that is not preceded or followed by another.
      */
-    int leading_consonant{};
+    static constexpr std::uint16_t not_korean_character = 19 << 10 | 28;
     /**
-     * The vowel of this @link korean_character @endlink instance.
+     * The jamo indices of this @link korean_character @endlink instance, packed as
+     * <code>leading_consonant << 10 | vowel << 5 | trailing_consonant</code> with the trailing consonant <code>0</code> if there is none,
+     * or @link not_korean_character @endlink.
      */
-    int vowel{};
+    std::uint16_t jamo = not_korean_character;
+protected:
     /**
-     * The trailing consonant of this @link korean_character @endlink instance.
+     * @brief Holds every romanization produced by the pronunciation rules of a romanization system as offsets into a single packed string.
+     * @details Defined below @link korean_character @endlink, as its tables are generated from the rules of the system at compile time.
      */
-    int trailing_consonant{};
+    template <class System>
+    struct pronunciation_table;
+public:
     /**
-     * The original character passed through the constructor.
+     * The trailing consonant index passed to the leading consonant rules of a romanization system for a Hangul character
+     * that is not preceded by another, as opposed to <code>-1</code> for one preceded by a Hangul character without a trailing consonant.
      */
-    wchar_t c{};
-protected:
+    static constexpr int no_preceding_character = -2;
+    /**
+     * Creates an instance of @link korean_character @endlink that is not a Hangul character.
+     */
+    explicit korean_character() = default;
+    /**
+     * Creates an instance of @link korean_character @endlink with the given character.
+     *
+     * @param _c A character.
+     */
+    explicit korean_character(char32_t _c);
+    /**
+     * Decomposes a Hangul character into its jamo components, assigning them to @link jamo @endlink.
+     *
+     * For an explanation of the decomposition algorithm, please reference Section 3.12 of the Unicode Standard linked below.
+     *
+     * @param _c The Hangul character to be decomposed into its jamo components.
+     * @see <a href="https://en.wikipedia.org/wiki/Hangul_Jamo_(Unicode_block)">Section 3.12 of the Unicode Standard</a>
+     */
+    void decompose_character(char32_t _c);
+    /**
+     * @return <code>true</code> if this @link korean_character @endlink instance is a valid Hangul character.
+     */
+    bool is_korean_character() const { return jamo != not_korean_character; }
+    /**
+     * @return The index of the leading consonant, which is <code>19</code> if this is not a Hangul character.
+     */
+    unsigned leading_consonant() const { return jamo >> 10; }
+    /**
+     * @return The index of the vowel.
+     */
+    unsigned vowel() const { return jamo >> 5 & 0x1F; }
+    /**
+     * @return The index of the trailing consonant, which is <code>0</code> if there is none or <code>28</code> if this is not a Hangul character.
+     */
+    unsigned trailing_consonant() const { return jamo & 0x1F; }
+    /**
+     * @return The index of this Hangul character in the Hangul Syllables block, counting from <code>U+AC00</code>.
+     */
+    unsigned index() const { return (leading_consonant() * vowel_jamo_count + vowel()) * trailing_consonant_jamo_count + trailing_consonant(); }
+    /**
+     * Romanizes a Hangul character while taking into account its surrounding characters.
+     *
+     * Characters that are not Hangul do not affect the romanization of their neighbors.
+     *
+     * @param previous_character The character preceding the current character.
+     * @param next_character The character following the current character.
+     * @tparam System The romanization system.
+     * @param result The buffer the romanization of the Hangul character is written to, which must have room for at least
+     * @link pronunciation_table::max_length @endlink + @link pronunciation_table::copy_length @endlink bytes.
+     * @return The end of the romanization written to <code>result</code>.
+     */
+    template <class System>
+    char* romanize_character(const korean_character& previous_character, const korean_character& next_character, char* result) const;
+};
+/**
+ * @brief An informal spelling of a romanization, such as <code>sh</code> for <code>s</code>, which @link basic_deromanizer @endlink accepts at a cost
+ * and @link basic_romanization_fingerprinter @endlink fingerprints.
+ */
+struct korean_spelling_variant {
+    /**
+     * The informal spelling, in lowercase.
+     */
+    std::string_view written;
     /**
-     * If <code>true</code>, this @link korean_character @endlink instance does not contain anything and is essentially <code>null</code>.
+     * The romanization it stands for.
      */
-    bool is_empty = false;
+    std::string_view romanized;
     /**
-     * If <code>true</code>, this @link korean_character @endlink instance is a valid Hangul character and can be broken apart into its jamo components.
+     * The cost added to a parse that uses it, on the scale of @link basic_deromanizer::candidate::cost @endlink.
      */
-    bool is_korean_character = true;
+    unsigned cost;
+};
+/**
+ * @brief The pronunciation rules of the Revised Romanization of Korean, the official romanization system of South Korea.
+ * @details A romanization system is a class with nested <code>leading_consonant_pronunciation</code>, <code>vowel_pronunciation</code>
+ * and <code>trailing_consonant_pronunciation</code> classes, whose <code>get_pronunciation</code> functions describe its rules.
+ * They are evaluated at compile time to fill a table for each system, so the systems share the romanization loop without branching on the system in it.
+ * Its <code>spelling_variants</code> list the informal spellings @link basic_deromanizer @endlink accepts when parsing romanizations back
+ * and @link basic_romanization_fingerprinter @endlink fingerprints.
+ *
+ * @see <a href="https://www.korean.go.kr/front_eng/roman/roman_01.do">Revised Romanization of Korean system transcription summary</a>
+ */
+struct revised_romanization {
     /**
      * @brief Romanizes the leading consonant of a @link korean_character @endlink instance.
      * @details Romanizes the leading consonant of a @link korean_character @endlink instance while taking into account the preceding character's trailing consonant.
@@ -98,14 +198,17 @@ protected:
          * Ordered according to their positions in the Unicode character table, which is
          * ㄱ, ㄲ, ㄴ, ㄷ, ㄸ, ㄹ, ㅁ, ㅂ, ㅃ, ㅅ, ㅆ, ㅇ, ㅈ, ㅉ, ㅊ, ㅋ, ㅌ, ㅍ, and ㅎ.
          */
-        static std::string pronunciations[];
+        static constexpr std::string_view pronunciations[19] = {"g", "kk", "n", "d", "tt", "r", "m", "b", "pp", "s", "ss", "", "j", "jj", "ch", "k", "t", "p", "h"};
         /**
          * Romanizes the leading consonant given the preceding character's trailing consonant.
-         * @param previous_trailing_consonant_index The pronunciations index of the preceding character's trailing consonant.
+         *
+         * This function only describes the rules; it is evaluated at compile time to fill @link korean_character::pronunciation_table @endlink.
+         * @param previous_trailing_consonant_index The pronunciations index of the preceding character's trailing consonant,
+         * <code>-1</code> if it has none, or @link korean_character::no_preceding_character @endlink if there is no preceding Hangul character.
          * @param index The pronunciations index of the leading consonant.
          * @return The romanization of the leading consonant.
          */
-        static std::string get_pronunciation(int previous_trailing_consonant_index, int index);
+        static constexpr std::string_view get_pronunciation(int previous_trailing_consonant_index, int index);
     };
     /**
      * @brief Romanizes the vowel of a @link korean_character @endlink instance.
@@ -117,13 +220,15 @@ protected:
          * Ordered according to their positions in the Unicode character table, which is
          * ㅏ, ㅐ, ㅑ, ㅒ, ㅓ, ㅔ, ㅕ, ㅖ, ㅗ, ㅘ, ㅙ, ㅚ, ㅛ, ㅜ, ㅝ, ㅞ, ㅟ, ㅠ, ㅡ, ㅢ, and ㅣ.
          */
-        static std::string pronunciations[];
+        static constexpr std::string_view pronunciations[21] = {"a", "ae", "ya", "yae", "eo", "e", "yeo", "ye", "o", "wa", "wae", "oe", "yo", "u", "wo", "we", "wi", "yu", "eu", "ui", "i"};
         /**
          * Romanizes the vowel.
+         *
+         * This function only describes the rules; it is evaluated at compile time to fill @link korean_character::pronunciation_table @endlink.
          * @param index The pronunciations index of the vowel.
          * @return The romanization of the vowel.
          */
-        static std::string get_pronunciation(int index);
+        static constexpr std::string_view get_pronunciation(int index);
     };
     /**
      * @brief Romanizes the trailing consonant of a @link korean_character @endlink instance.
@@ -140,59 +245,2272 @@ protected:
          * Ordered according to their positions in the Unicode character table, which is
          * ㄱ, ㄲ, ㄳ, ㄴ, ㄵ, ㄶ, ㄷ, ㄹ, ㄺ, ㄻ, ㄼ, ㄽ, ㄾ, ㄿ, ㅀ, ㅁ, ㅂ, ㅄ, ㅅ, ㅆ, ㅇ, ㅈ, ㅊ, ㅋ, ㅌ, ㅍ, and ㅎ.
          */
-        static std::string pronunciations[];
+        static constexpr std::string_view pronunciations[27] = {"k", "k", "k", "n", "n", "n", "d", "l", "k", "m", "l", "l", "l", "l", "l", "m", "p", "p", "t", "t", "ng", "t", "t", "k", "t", "p", "t"};
         /**
          * Romanizes the trailing consonant given the following character's leading consonant.
-         * @param next_leading_consonant_index The pronunciations index of the following character's leading consonant.
+         *
+         * This function only describes the rules; it is evaluated at compile time to fill @link korean_character::pronunciation_table @endlink.
+         * @param next_leading_consonant_index The pronunciations index of the following character's leading consonant,
+         * or <code>-1</code> if there is no following Hangul character.
          * @param index The pronunciations index of the trailing consonant.
          * @return The romanization of the trailing consonant.
          */
-        static std::string get_pronunciation(int next_leading_consonant_index, int index);
+        static constexpr std::string_view get_pronunciation(int next_leading_consonant_index, int index);
     };
     /**
-     * Creates an empty instance of @link korean_character @endlink.
-     *
-     * @see @link is_empty @endlink
+     * The informal spellings most often found in place of the Revised Romanization, such as the unvoiced consonants
+     * of McCune-Reischauer (<code>Pusan</code> for 부산) and English spellings of vowels (<code>oo</code> for <code>u</code>).
      */
-    explicit korean_character();
+    static constexpr korean_spelling_variant spelling_variants[] = {
+        {"sh", "s", 2}, {"k", "g", 3}, {"t", "d", 3}, {"p", "b", 3}, {"ch", "j", 3}, {"r", "l", 3}, {"l", "r", 3},
+        {"o", "eo", 3}, {"u", "eo", 4}, {"u", "eu", 3}, {"e", "ae", 3}, {"ae", "e", 3}, {"oo", "u", 3}, {"ee", "i", 3},
+        {"yo", "yeo", 3}, {"weo", "wo", 2}, {"oi", "oe", 3}};
+};
+constexpr std::string_view revised_romanization::leading_consonant_pronunciation::get_pronunciation(const int previous_trailing_consonant_index, const int index) {
+    if (index < 0)
+        return "";
+    switch (index) {
+        // ㄱ
+        case 0:
+            switch (previous_trailing_consonant_index) {
+                case ㄺ:
+                case ㄻ:
+                case ㄼ:
+                case ㄽ:
+                case ㄾ:
+                case ㄿ:
+                case ㅀ:
+                case ㅎ: return "k";
+                default: return pronunciations[index];
+            }
+        // ㄴ
+        case 2:
+            switch (previous_trailing_consonant_index) {
+                case ㄹ:
+                case ㅀ: return "l";
+                default: return pronunciations[index];
+            }
+        // ㄷ
+        case 3:
+            switch (previous_trailing_consonant_index) {
+                case ㄾ:
+                case ㄶ:
+                case ㅎ: return "t";
+                default: return pronunciations[index];
+            }
+        // ㄹ
+        case 5:
+            switch (previous_trailing_consonant_index) {
+                case ㄱ:
+                case ㄲ:
+                case ㄳ:
+                case ㄺ:
+                case ㄼ:
+                case ㄿ:
+                case ㅁ:
+                case ㅂ:
+                case ㅄ:
+                case ㅇ:
+                case ㅋ:
+                case ㅍ: return "n";
+                case ㄴ:
+                case ㄵ:
+                case ㄶ:
+                case ㄷ:
+                case ㄹ:
+                case ㄻ:
+                case ㄽ:
+                case ㄾ:
+                case ㅀ:
+                case ㅅ:
+                case ㅆ:
+                case ㅈ:
+                case ㅊ:
+                case ㅌ:
+                case ㅎ: return "l";
+                default: return pronunciations[index];
+            }
+        // ㅇ
+        case 11:
+            switch (previous_trailing_consonant_index) {
+                case ㄱ:
+                case ㄺ: return "g";
+                case ㄲ: return "kk";
+                case ㄳ:
+                case ㄽ:
+                case ㅄ:
+                case ㅅ: return "s";
+                case ㄴ:
+                case ㄶ: return "n";
+                case ㄷ: return "d";
+                case ㄵ:
+                case ㅈ: return "j";
+                case ㄹ: return "r";
+                case ㅀ: return "l";
+                case ㄻ:
+                case ㅁ: return "m";
+                case ㄼ:
+                case ㅂ: return "b";
+                case ㄾ:
+                case ㅌ: return "ch";
+                case ㅆ: return "ss";
+                case ㅊ: return "ch";
+                case ㅋ: return "k";
+                case ㄿ:
+                case ㅍ: return "p";
+                default: return pronunciations[index];
+            }
+        // ㅈ
+        case 12:
+            switch (previous_trailing_consonant_index) {
+                case ㅎ: return "ch";
+                default: return pronunciations[index];
+            }
+        // ㅉ, ㅊ, ㅋ, ㅌ
+        case 13:
+        case 14:
+        case 15:
+        case 16:
+            switch (previous_trailing_consonant_index) {
+                case ㅈ:
+                case ㅊ: return "ch";
+                default: return pronunciations[index];
+            }
+        // ㅎ
+        case 18:
+            switch (previous_trailing_consonant_index) {
+                case ㄲ: return "kk";
+                case ㄷ:
+                case ㄾ:
+                case ㅈ:
+                case ㅊ:
+                case ㅌ: return "ch";
+                case ㄺ: return "k";
+                case ㅂ:
+                case ㄼ: return "p";
+                case ㄽ: return "s";
+                case ㅀ: return "r";
+                default: return pronunciations[index];
+            }
+        default: return pronunciations[index];
+    }
+}
+constexpr std::string_view revised_romanization::vowel_pronunciation::get_pronunciation(const int index) {
+    if (index < 0)
+        return "";
+    return pronunciations[index];
+}
+constexpr std::string_view revised_romanization::trailing_consonant_pronunciation::get_pronunciation(const int next_leading_consonant_index, const int index) {
+    if (index < 0)
+        return "";
+    switch (index) {
+        // ㄱ
+        case 0:
+            switch (next_leading_consonant_index) {
+                case ㄲ:
+                case ㅇ:
+                case ㅋ: return "";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "ng";
+                default: return pronunciations[index];
+            }
+        // ㄲ
+        case 1:
+            switch (next_leading_consonant_index) {
+                case ㄲ:
+                case ㅇ:
+                case ㅋ:
+                case ㅎ: return "";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "ng";
+                default: return pronunciations[index];
+            }
+        // ㄳ
+        case 2:
+            switch (next_leading_consonant_index) {
+                case ㄲ:
+                case ㅋ: return "";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "ng";
+                default: return pronunciations[index];
+            }
+        // ㄴ
+        case 3:
+            switch (next_leading_consonant_index) {
+                case ㄹ: return "l";
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㄷ
+        case 6:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㅁ: return "n";
+                case ㄹ: return "l";
+                case ㄸ:
+                case ㅇ:
+                case ㅌ:
+                case ㅎ: return "";
+                default: return pronunciations[index];
+            }
+        // ㄹ
+        case 7:
+            switch (next_leading_consonant_index) {
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㄺ
+        case 8:
+            switch (next_leading_consonant_index) {
+                case ㄱ:
+                case ㄲ:
+                case ㅇ:
+                case ㅎ: return "l";
+                case ㄴ:
+                case ㄹ:
+                case ㅁ: return "ng";
+                default: return pronunciations[index];
+            }
+        // ㄻ
+        case 9:
+            switch (next_leading_consonant_index) {
+                case ㄹ:
+                case ㅁ:
+                case ㅇ: return "l";
+                default: return pronunciations[index];
+            }
+        // ㄼ
+        case 10:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㄹ: return "m";
+                case ㄷ:
+                case ㄸ:
+                case ㅂ:
+                case ㅅ:
+                case ㅆ:
+                case ㅈ:
+                case ㅉ:
+                case ㅊ:
+                case ㅋ:
+                case ㅌ:
+                case ㅎ: return "p";
+                case ㅃ: return "";
+                default: return pronunciations[index];
+            }
+        // ㄿ
+        case 13:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㄹ: return "m";
+                case ㄷ:
+                case ㄸ:
+                case ㅂ:
+                case ㅅ:
+                case ㅆ:
+                case ㅈ:
+                case ㅉ:
+                case ㅊ:
+                case ㅋ:
+                case ㅌ:
+                case ㅎ: return "p";
+                case ㅃ:
+                case ㅍ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅀ
+        case 14:
+            switch (next_leading_consonant_index) {
+                case ㅎ:
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅁ
+        case 15:
+            switch (next_leading_consonant_index) {
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅂ
+        case 16:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㄹ:
+                case ㅁ: return "m";
+                case ㅃ:
+                case ㅇ:
+                case ㅎ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅄ
+        case 17:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㄹ:
+                case ㅁ: return "m";
+                case ㅃ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅅ, ㅆ, ㅈ, ㅊ
+        case 18:
+        case 19:
+        case 21:
+        case 22:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㅁ: return "n";
+                case ㄹ: return "l";
+                case ㄸ:
+                case ㅇ:
+                case ㅌ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅋ
+        case 23:
+            switch (next_leading_consonant_index) {
+                case ㄲ:
+                case ㅇ: return "";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "ng";
+                default: return pronunciations[index];
+            }
+        // ㅌ
+        case 24:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㅁ: return "n";
+                case ㄸ:
+                case ㅇ:
+                case ㅎ: return "";
+                case ㄹ: return "l";
+                default: return pronunciations[index];
+            }
+        // ㅍ
+        case 25:
+            switch (next_leading_consonant_index) {
+                case ㅃ:
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅎ
+        case 26:
+            switch (next_leading_consonant_index) {
+                case ㄱ:
+                case ㄲ:
+                case ㄷ:
+                case ㄸ:
+                case ㅇ:
+                case ㅈ:
+                case ㅉ:
+                case ㅊ:
+                case ㅋ:
+                case ㅌ:
+                case ㅍ:
+                case ㅎ: return "";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "n";
+                default: return pronunciations[index];
+            }
+        default: return pronunciations[index];
+    }
+}
+/**
+ * @brief The pronunciation rules of the McCune-Reischauer romanization system, as published in 1939.
+ * @details Follows the same assimilation rules as @link revised_romanization @endlink, but unlike it, voices ㄱ, ㄷ, ㅂ, and ㅈ only between voiced sounds,
+ * marks aspirated consonants with an apostrophe, writes ㅓ and ㅡ with a breve, and separates ㄴ from a following ㄱ with an apostrophe.
+ * Romanizations are lowercase, as with @link revised_romanization @endlink.
+ * ㅅ is always written "s", without the "sh" before ㅣ, ㅑ, ㅕ, ㅛ, ㅠ, and ㅟ of the variant South Korea used from 1984 to 2000.
+ *
+ * @see <a href="https://en.wikipedia.org/wiki/McCune%E2%80%93Reischauer">McCune-Reischauer on Wikipedia</a>
+ */
+struct mccune_reischauer {
     /**
-     * Creates an instance of @link korean_character @endlink with the given character.
-     *
-     * @param _c A character.
+     * @brief Romanizes the leading consonant of a @link korean_character @endlink instance.
+     * @details Romanizes the leading consonant of a @link korean_character @endlink instance while taking into account the preceding character's trailing consonant.
+     */
+    struct leading_consonant_pronunciation {
+       /**
+        * Contains every trailing consonant for readability purposes when parsing the preceding character's trailing consonant in @link get_pronunciation @endlink.
+        */
+        enum trailing_consonants { ㄱ, ㄲ, ㄳ, ㄴ, ㄵ, ㄶ, ㄷ, ㄹ, ㄺ, ㄻ, ㄼ, ㄽ, ㄾ, ㄿ, ㅀ, ㅁ, ㅂ, ㅄ, ㅅ, ㅆ, ㅇ, ㅈ, ㅊ, ㅋ, ㅌ, ㅍ, ㅎ };
+        /**
+         * Contains the pronunciation of every possible leading consonant between two vowels.
+         *
+         * Ordered according to their positions in the Unicode character table, which is
+         * ㄱ, ㄲ, ㄴ, ㄷ, ㄸ, ㄹ, ㅁ, ㅂ, ㅃ, ㅅ, ㅆ, ㅇ, ㅈ, ㅉ, ㅊ, ㅋ, ㅌ, ㅍ, and ㅎ.
+         */
+        static constexpr std::string_view pronunciations[19] = {"g", "kk", "n", "d", "tt", "r", "m", "b", "pp", "s", "ss", "", "j", "tch", "ch'", "k'", "t'", "p'", "h"};
+        /**
+         * Romanizes the leading consonant given the preceding character's trailing consonant.
+         *
+         * This function only describes the rules; it is evaluated at compile time to fill @link korean_character::pronunciation_table @endlink.
+         * @param previous_trailing_consonant_index The pronunciations index of the preceding character's trailing consonant,
+         * <code>-1</code> if it has none, or @link korean_character::no_preceding_character @endlink if there is no preceding Hangul character.
+         * @param index The pronunciations index of the leading consonant.
+         * @return The romanization of the leading consonant.
+         */
+        static constexpr std::string_view get_pronunciation(int previous_trailing_consonant_index, int index);
+    };
+    /**
+     * @brief Romanizes the vowel of a @link korean_character @endlink instance.
+     */
+    struct vowel_pronunciation {
+        /**
+         * Contains the pronunciation for every possible vowel.
+         *
+         * Ordered according to their positions in the Unicode character table, which is
+         * ㅏ, ㅐ, ㅑ, ㅒ, ㅓ, ㅔ, ㅕ, ㅖ, ㅗ, ㅘ, ㅙ, ㅚ, ㅛ, ㅜ, ㅝ, ㅞ, ㅟ, ㅠ, ㅡ, ㅢ, and ㅣ.
+         */
+        static constexpr std::string_view pronunciations[21] = {"a", "ae", "ya", "yae", "ŏ", "e", "yŏ", "ye", "o", "wa", "wae", "oe", "yo", "u", "wŏ", "we", "wi", "yu", "ŭ", "ŭi", "i"};
+        /**
+         * Romanizes the vowel.
+         *
+         * This function only describes the rules; it is evaluated at compile time to fill @link korean_character::pronunciation_table @endlink.
+         * @param index The pronunciations index of the vowel.
+         * @return The romanization of the vowel.
+         */
+        static constexpr std::string_view get_pronunciation(int index);
+    };
+    /**
+     * @brief Romanizes the trailing consonant of a @link korean_character @endlink instance.
+     * @details Romanizes the trailing consonant of a @link korean_character @endlink instance while taking into account the following character's leading consonant.
+     */
+    struct trailing_consonant_pronunciation {
+       /**
+        * Contains every leading consonant for readability purposes when parsing the following character's leading consonant in @link get_pronunciation @endlink.
+        */
+        enum leading_consonants { ㄱ, ㄲ, ㄴ, ㄷ, ㄸ, ㄹ, ㅁ, ㅂ, ㅃ, ㅅ, ㅆ, ㅇ, ㅈ, ㅉ, ㅊ, ㅋ, ㅌ, ㅍ, ㅎ };
+        /**
+         * Contains the default pronunciation for every possible trailing consonant.
+         *
+         * Ordered according to their positions in the Unicode character table, which is
+         * ㄱ, ㄲ, ㄳ, ㄴ, ㄵ, ㄶ, ㄷ, ㄹ, ㄺ, ㄻ, ㄼ, ㄽ, ㄾ, ㄿ, ㅀ, ㅁ, ㅂ, ㅄ, ㅅ, ㅆ, ㅇ, ㅈ, ㅊ, ㅋ, ㅌ, ㅍ, and ㅎ.
+         */
+        static constexpr std::string_view pronunciations[27] = {"k", "k", "k", "n", "n", "n", "t", "l", "k", "m", "l", "l", "l", "p", "l", "m", "p", "p", "t", "t", "ng", "t", "t", "k", "t", "p", "t"};
+        /**
+         * Romanizes the trailing consonant given the following character's leading consonant.
+         *
+         * This function only describes the rules; it is evaluated at compile time to fill @link korean_character::pronunciation_table @endlink.
+         * @param next_leading_consonant_index The pronunciations index of the following character's leading consonant,
+         * or <code>-1</code> if there is no following Hangul character.
+         * @param index The pronunciations index of the trailing consonant.
+         * @return The romanization of the trailing consonant.
+         */
+        static constexpr std::string_view get_pronunciation(int next_leading_consonant_index, int index);
+    };
+    /**
+     * The informal spellings most often found in place of McCune-Reischauer, which mostly drop its breves and apostrophes.
+     */
+    static constexpr korean_spelling_variant spelling_variants[] = {
+        {"o", "ŏ", 2}, {"u", "ŭ", 2}, {"eo", "ŏ", 2}, {"eu", "ŭ", 2}, {"k", "k'", 2}, {"t", "t'", 2}, {"p", "p'", 2},
+        {"ch", "ch'", 2}, {"j", "ch", 3}, {"g", "k", 3}, {"d", "t", 3}, {"b", "p", 3}, {"n", "n'", 2}, {"sh", "s", 2},
+        {"oo", "u", 3}, {"ee", "i", 3}, {"r", "l", 3}, {"l", "r", 3}};
+};
+constexpr std::string_view mccune_reischauer::leading_consonant_pronunciation::get_pronunciation(const int previous_trailing_consonant_index, const int index) {
+    if (index < 0)
+        return "";
+    switch (index) {
+        // ㄱ
+        case 0:
+            switch (previous_trailing_consonant_index) {
+                // after a vowel
+                case -1:
+                case ㄴ:
+                case ㄹ:
+                case ㅁ:
+                case ㅇ: return pronunciations[index];
+                case ㄶ:
+                case ㅀ:
+                case ㅎ: return "k'";
+                default: return "k";
+            }
+        // ㄴ
+        case 2:
+            switch (previous_trailing_consonant_index) {
+                case ㄹ:
+                case ㄼ:
+                case ㄽ:
+                case ㄾ:
+                case ㅀ: return "l";
+                default: return pronunciations[index];
+            }
+        // ㄷ
+        case 3:
+            switch (previous_trailing_consonant_index) {
+                case -1:
+                case ㄴ:
+                case ㄹ:
+                case ㅁ:
+                case ㅇ: return pronunciations[index];
+                case ㄶ:
+                case ㄾ:
+                case ㅀ:
+                case ㅎ: return "t'";
+                default: return "t";
+            }
+        // ㄹ
+        case 5:
+            switch (previous_trailing_consonant_index) {
+                case -1:
+                case korean_character::no_preceding_character: return pronunciations[index];
+                case ㄴ:
+                case ㄵ:
+                case ㄶ:
+                case ㄹ:
+                case ㄼ:
+                case ㄽ:
+                case ㄾ:
+                case ㅀ: return "l";
+                default: return "n";
+            }
+        // ㅂ
+        case 7:
+            switch (previous_trailing_consonant_index) {
+                case -1:
+                case ㄴ:
+                case ㄹ:
+                case ㅁ:
+                case ㅇ: return pronunciations[index];
+                case ㅎ: return "p'";
+                default: return "p";
+            }
+        // ㅇ
+        case 11:
+            switch (previous_trailing_consonant_index) {
+                case ㄱ:
+                case ㄺ: return "g";
+                case ㄲ: return "kk";
+                case ㄳ:
+                case ㄽ:
+                case ㅄ:
+                case ㅅ: return "s";
+                case ㄴ:
+                case ㄶ: return "n";
+                case ㄷ: return "d";
+                case ㄵ:
+                case ㅈ: return "j";
+                case ㄹ:
+                case ㅀ: return "r";
+                case ㄻ:
+                case ㅁ: return "m";
+                case ㄼ:
+                case ㅂ: return "b";
+                case ㄾ:
+                case ㅌ:
+                case ㅊ: return "ch'";
+                case ㅆ: return "ss";
+                case ㅋ: return "k'";
+                case ㄿ:
+                case ㅍ: return "p'";
+                default: return pronunciations[index];
+            }
+        // ㅈ
+        case 12:
+            switch (previous_trailing_consonant_index) {
+                case -1:
+                case ㄴ:
+                case ㄹ:
+                case ㅁ:
+                case ㅇ: return pronunciations[index];
+                case ㄶ:
+                case ㅀ:
+                case ㅎ: return "ch'";
+                default: return "ch";
+            }
+        // ㅎ
+        case 18:
+            switch (previous_trailing_consonant_index) {
+                case ㄱ:
+                case ㄲ:
+                case ㄺ:
+                case ㅋ: return "k'";
+                case ㄷ:
+                case ㅅ:
+                case ㅆ:
+                case ㅈ:
+                case ㅊ:
+                case ㅌ: return "t'";
+                case ㄼ:
+                case ㅂ:
+                case ㅍ: return "p'";
+                default: return pronunciations[index];
+            }
+        default: return pronunciations[index];
+    }
+}
+constexpr std::string_view mccune_reischauer::vowel_pronunciation::get_pronunciation(const int index) {
+    if (index < 0)
+        return "";
+    return pronunciations[index];
+}
+constexpr std::string_view mccune_reischauer::trailing_consonant_pronunciation::get_pronunciation(const int next_leading_consonant_index, const int index) {
+    if (index < 0)
+        return "";
+    switch (index) {
+        // ㄱ, ㄲ, ㅋ
+        case 0:
+        case 1:
+        case 23:
+            switch (next_leading_consonant_index) {
+                case ㅇ:
+                case ㅎ: return "";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "ng";
+                default: return pronunciations[index];
+            }
+        // ㄳ
+        case 2:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "ng";
+                default: return pronunciations[index];
+            }
+        // ㄴ
+        case 3:
+            switch (next_leading_consonant_index) {
+                // distinguishes n'g from ng
+                case ㄱ: return "n'";
+                case ㄹ: return "l";
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㄵ
+        case 4:
+            switch (next_leading_consonant_index) {
+                case ㄹ: return "l";
+                default: return pronunciations[index];
+            }
+        // ㄶ
+        case 5:
+            switch (next_leading_consonant_index) {
+                case ㄹ: return "l";
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㄷ, ㅅ, ㅆ, ㅈ, ㅊ, ㅌ
+        case 6:
+        case 18:
+        case 19:
+        case 21:
+        case 22:
+        case 24:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "n";
+                case ㅇ:
+                case ㅎ: return "";
+                default: return pronunciations[index];
+            }
+        // ㄹ
+        case 7:
+            switch (next_leading_consonant_index) {
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㄺ
+        case 8:
+            switch (next_leading_consonant_index) {
+                case ㄱ:
+                case ㅇ:
+                case ㅎ: return "l";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "ng";
+                default: return pronunciations[index];
+            }
+        // ㄻ
+        case 9:
+            switch (next_leading_consonant_index) {
+                case ㅇ: return "l";
+                default: return pronunciations[index];
+            }
+        // ㄿ
+        case 13:
+            switch (next_leading_consonant_index) {
+                case ㅇ: return "l";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "m";
+                default: return pronunciations[index];
+            }
+        // ㅀ
+        case 14:
+            switch (next_leading_consonant_index) {
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅁ
+        case 15:
+            switch (next_leading_consonant_index) {
+                case ㅇ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅂ, ㅍ
+        case 16:
+        case 25:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "m";
+                case ㅇ:
+                case ㅎ: return "";
+                default: return pronunciations[index];
+            }
+        // ㅄ
+        case 17:
+            switch (next_leading_consonant_index) {
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "m";
+                default: return pronunciations[index];
+            }
+        // ㅎ
+        case 26:
+            switch (next_leading_consonant_index) {
+                case ㄱ:
+                case ㄷ:
+                case ㅇ:
+                case ㅈ:
+                case ㅎ: return "";
+                case ㄴ:
+                case ㅁ:
+                case ㄹ: return "n";
+                default: return pronunciations[index];
+            }
+        default: return pronunciations[index];
+    }
+}
+template <class System>
+struct korean_character::pronunciation_table {
+    /**
+     * The location of a romanization inside @link blob @endlink.
+     */
+    struct entry {
+        unsigned char offset;
+        unsigned char length;
+    };
+    /**
+     * The amount of bytes @link append @endlink copies regardless of the length of the romanization,
+     * so that it compiles to a single load and store instead of a variable-length copy.
+     */
+    static constexpr std::size_t copy_length = 4;
+    /**
+     * Calls a function with every romanization the pronunciation rules of the system can produce.
+     */
+    template <class Function>
+    static constexpr void for_each_romanization(Function f) {
+        for (int previous = no_preceding_character; previous < 27; ++previous)
+            for (int index = 0; index < 19; ++index)
+                f(System::leading_consonant_pronunciation::get_pronunciation(previous, index));
+        for (int index = 0; index < 21; ++index)
+            f(System::vowel_pronunciation::get_pronunciation(index));
+        for (int index = 0; index < 27; ++index)
+            for (int next = -1; next < 19; ++next)
+                f(System::trailing_consonant_pronunciation::get_pronunciation(next, index));
+    }
+    /**
+     * @brief Every romanization of the system, packed into as few characters as possible.
+     */
+    struct packed_romanizations {
+        char characters[256];
+        std::size_t size;
+    };
+    /**
+     * Packs every romanization of the system, adding each one unless it is already contained in the ones added before it.
+     */
+    static constexpr packed_romanizations packed = [] {
+        packed_romanizations p{};
+        // longer romanizations first, so that the shorter ones are more likely to be contained in them
+        for (std::size_t length = copy_length; length; --length) {
+            for_each_romanization([&p, length](const std::string_view s) {
+                if (s.size() > copy_length)
+                    throw "romanization is longer than copy_length";
+                if (s.size() != length || std::string_view(p.characters, p.size).find(s) != std::string_view::npos)
+                    return;
+                if (p.size + s.size() > sizeof(p.characters))
+                    throw "romanizations do not fit into the blob";
+                for (const char c : s)
+                    p.characters[p.size++] = c;
+            });
+        }
+        return p;
+    }();
+    /**
+     * Contains every romanization the pronunciation rules can produce as a substring.
+     */
+    static constexpr std::string_view blob = std::string_view(packed.characters, packed.size);
+    /**
+     * Locates a romanization inside @link blob @endlink.
+     */
+    static constexpr entry locate(const std::string_view s) {
+        std::size_t offset = 0;
+        // a plain search, since std::string_view::find is not a constant expression on static storage with some sanitizers
+        while (offset + s.size() < packed.size && std::string_view(packed.characters + offset, s.size()) != s)
+            ++offset;
+        return entry{static_cast<unsigned char>(offset), static_cast<unsigned char>(s.size())};
+    }
+    /**
+     * The romanization of every leading consonant, indexed by the preceding character's trailing consonant
+     * (<code>0</code> when it has none, or <code>28</code> when it is not Hangul) and the leading consonant.
+     */
+    static constexpr std::array<std::array<entry, 19>, 29> leading_consonants = [] {
+        std::array<std::array<entry, 19>, 29> table{};
+        for (int previous = 0; previous < 29; ++previous)
+            for (int index = 0; index < 19; ++index)
+                table[previous][index] = locate(System::leading_consonant_pronunciation::get_pronunciation(previous < 28 ? previous - 1 : no_preceding_character, index));
+        return table;
+    }();
+    /**
+     * The romanization of every vowel.
+     */
+    static constexpr std::array<entry, 21> vowels = [] {
+        std::array<entry, 21> table{};
+        for (int index = 0; index < 21; ++index)
+            table[index] = locate(System::vowel_pronunciation::get_pronunciation(index));
+        return table;
+    }();
+    /**
+     * The romanization of every trailing consonant (<code>0</code> for none), indexed by the trailing consonant and the following
+     * character's leading consonant (<code>19</code> when there is no following Hangul character).
+     */
+    static constexpr std::array<std::array<entry, 20>, 28> trailing_consonants = [] {
+        std::array<std::array<entry, 20>, 28> table{};
+        for (int index = 1; index < 28; ++index)
+            for (int next = 0; next < 20; ++next)
+                table[index][next] = locate(System::trailing_consonant_pronunciation::get_pronunciation(next < 19 ? next : -1, index - 1));
+        return table;
+    }();
+    /**
+     * The length of the longest romanization a single Hangul character can produce.
+     */
+    static constexpr std::size_t max_length = [] {
+        std::size_t leading = 0, vowel = 0, trailing = 0;
+        for (const auto& row : leading_consonants)
+            for (const entry e : row)
+                leading = e.length > leading ? e.length : leading;
+        for (const entry e : vowels)
+            vowel = e.length > vowel ? e.length : vowel;
+        for (const auto& row : trailing_consonants)
+            for (const entry e : row)
+                trailing = e.length > trailing ? e.length : trailing;
+        return leading + vowel + trailing;
+    }();
+    /**
+     * @link blob @endlink followed by enough zeros that @link copy_length @endlink bytes can be copied from every offset.
      */
-    explicit korean_character(wchar_t _c);
+    static constexpr std::array<char, blob.size() + copy_length> padded_blob = [] {
+        std::array<char, blob.size() + copy_length> padded{};
+        for (std::size_t i = 0; i < blob.size(); ++i)
+            padded[i] = blob[i];
+        return padded;
+    }();
     /**
-     * Decomposes a Hangul character into its jamo components, assigning them to the variables
-     * @link leading_consonant @endlink, @link vowel @endlink, and @link trailing_consonant @endlink.
+     * Writes the romanization located by an @link entry @endlink to a buffer,
+     * which must have room for @link copy_length @endlink bytes even if the romanization is shorter.
      *
-     * For an explanation of the decomposition algorithm, please reference Section 3.12 of the Unicode Standard linked below.
+     * @return The end of the romanization written to <code>result</code>.
+     */
+    static char* append(char* result, const entry e) {
+        std::memcpy(result, padded_blob.data() + e.offset, copy_length);
+        return result + e.length;
+    }
+};
+template <class System>
+char* korean_character::romanize_character(const korean_character& previous_character, const korean_character& next_character, char* result) const {
+    using table = pronunciation_table<System>;
+    result = table::append(result, table::leading_consonants[previous_character.trailing_consonant()][leading_consonant()]);
+    result = table::append(result, table::vowels[vowel()]);
+    return table::append(result, table::trailing_consonants[trailing_consonant()][next_character.leading_consonant()]);
+}
+#if __cpp_nontype_template_args >= 201911L
+/**
+ * @brief A UTF-8 string literal that can be passed as a template argument, such as to @link korean_romanizer::romanize_literal @endlink.
+ */
+template <std::size_t N>
+struct korean_fixed_string {
+    /**
+     * The characters of the literal, including its terminating null character.
+     */
+    char characters[N]{};
+    constexpr korean_fixed_string(const char (&s)[N]) {
+        for (std::size_t i = 0; i < N; ++i)
+            characters[i] = s[i];
+    }
+#if __cpp_char8_t
+    constexpr korean_fixed_string(const char8_t (&s)[N]) {
+        for (std::size_t i = 0; i < N; ++i)
+            characters[i] = static_cast<char>(s[i]);
+    }
+#endif
+    /**
+     * @return The characters of the literal, excluding its terminating null character.
+     */
+    constexpr std::string_view view() const { return std::string_view(characters, N - 1); }
+};
+#endif
+class korean_romanizer_offset_map;
+class korean_romanizer_dictionary;
+
+/**
+ * @brief Chooses what romanizing does with bytes that are not valid UTF-8.
+ * @details Every maximal part of a sequence that cannot be completed into a valid one counts as a single error,
+ * as the Unicode Standard recommends for U+FFFD substitution, so that the bytes following it are never swallowed.
+ */
+enum class korean_romanizer_error_policy {
+    /**
+     * Throws <code>std::range_error</code>, as romanizing always does without an error policy.
+     */
+    throw_exception,
+    /**
+     * Replaces every error with U+FFFD REPLACEMENT CHARACTER.
+     */
+    replace,
+    /**
+     * Copies the bytes of every error as they are.
+     */
+    pass_through,
+    /**
+     * Drops the bytes of every error.
+     */
+    skip,
+};
+/**
+ * @brief Reports the errors found while romanizing a string under a @link korean_romanizer_error_policy @endlink.
+ */
+struct korean_romanizer_result {
+    /**
+     * The amount of errors in the string.
+     */
+    std::size_t error_count = 0;
+    /**
+     * The offset of the first error in the string in bytes, or <code>std::string_view::npos</code> if there is none.
+     */
+    std::size_t first_error_offset = std::string_view::npos;
+
+    /**
+     * @return Whether the string was valid UTF-8.
+     */
+    explicit operator bool() const { return !error_count; }
+};
+
+/**
+ * @brief Counts what the romanizers do, such as for exporting to a metrics system, when the library is compiled with
+ * <code>KOREAN_ROMANIZER_METRICS</code> defined. Otherwise, counting is compiled away and every snapshot is empty.
+ * @details Every thread counts into its own block of counters, which only it writes to, so counting takes no locks and no atomic read-modify-write.
+ * A snapshot sums the blocks of every thread, including threads that have exited, whose blocks are handed to new threads with their counts kept.
+ * Every counter only grows, so an exporter polling snapshots reports the differences between them.
+ *
+ * A call is a call to a function that romanizes into a string or a buffer, including the stream, batch and cache classes,
+ * but not one made by another such function. Hangul characters and other code points are counted wherever they are romanized,
+ * including by @link basic_romanized_view @endlink and on the threads of parallel romanization.
+ */
+class korean_romanizer_metrics {
+public:
+    /**
+     * Whether the library counts anything, which must match how the library itself was compiled.
+     */
+#ifdef KOREAN_ROMANIZER_METRICS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    /**
+     * The amount of buckets of the latency histogram. Bucket <code>i</code> counts the calls that took from
+     * <code>2^i</code> up to <code>2^(i + 1)</code> nanoseconds, and the last one also counts every slower call.
+     */
+    static constexpr std::size_t latency_bucket_count = 40;
+    /**
+     * @brief The sums of the counters of every thread at one point in time.
+     */
+    struct snapshot {
+        std::uint64_t calls = 0;
+        /**
+         * The amount of calls that threw, such as on invalid UTF-8 without an error policy.
+         */
+        std::uint64_t failed_calls = 0;
+        std::uint64_t input_bytes = 0;
+        std::uint64_t output_bytes = 0;
+        /**
+         * The amount of calls whose result string grew its capacity.
+         */
+        std::uint64_t result_allocations = 0;
+        /**
+         * The amount of Hangul characters romanized, excluding the words matched by a @link korean_romanizer_dictionary @endlink.
+         */
+        std::uint64_t hangul_characters = 0;
+        /**
+         * The amount of code points left untouched, ASCII included.
+         */
+        std::uint64_t other_code_points = 0;
+        /**
+         * The amount of invalid UTF-8 sequences handled by a @link korean_romanizer_error_policy @endlink.
+         */
+        std::uint64_t invalid_sequences = 0;
+        /**
+         * The amount of leading consonants romanized differently than after a vowel, such as the ㄹ of 신라 (<code>silla</code>),
+         * which is how often the rules of <code>leading_consonant_pronunciation::get_pronunciation</code> that depend on the preceding character apply.
+         */
+        std::uint64_t changed_leading_consonants = 0;
+        /**
+         * The amount of trailing consonants romanized differently than at the end of a word, such as the ㄴ of 신라,
+         * which is how often the rules of <code>trailing_consonant_pronunciation::get_pronunciation</code> apply.
+         */
+        std::uint64_t changed_trailing_consonants = 0;
+        /**
+         * The amount of words found in and missing from every @link basic_romanizer_cache @endlink.
+         */
+        std::uint64_t cache_hits = 0;
+        std::uint64_t cache_misses = 0;
+        /**
+         * The amount of calls that took each range of nanoseconds, while the histogram is turned on.
+         */
+        std::array<std::uint64_t, latency_bucket_count> latency_histogram{};
+    };
+    /**
+     * Sums the counters of every thread. Counts made while the snapshot is taken may or may not be included.
      *
-     * @param _c The Hangul character to be decomposed into its jamo components.
-     * @see <a href="https://en.wikipedia.org/wiki/Hangul_Jamo_(Unicode_block)">Section 3.12 of the Unicode Standard</a>
+     * @return The snapshot, which is empty unless the library was compiled with <code>KOREAN_ROMANIZER_METRICS</code> defined.
      */
-    void decompose_character(wchar_t _c);
+    static snapshot take_snapshot();
     /**
-     * Romanizes a Hangul character while taking into account its surrounding characters.
+     * Turns the latency histogram on or off for every thread. It is off at first, as timing a call costs about as much as romanizing a short string.
      *
-     * @param previous_character The character preceding the current character.
-     * @param next_character The character following the current character.
-     * @return The romanization of the Hangul character.
+     * @param on Whether the duration of every call is to be counted.
      */
-    std::string romanize_character(const korean_character& previous_character, const korean_character& next_character);
+    static void set_latency_histogram(bool on);
 };
+
 /**
  * @brief Provides functionality for romanizing a Hangul string.
+ * @details Use @link korean_romanizer @endlink for the Revised Romanization of Korean.
+ * Every romanization system is compiled into its own romanization loop, so systems can be used side by side without slowing each other down.
+ *
+ * @tparam System The romanization system, which is @link revised_romanization @endlink or @link mccune_reischauer @endlink.
  */
-class korean_romanizer {
+template <class System>
+class basic_romanizer {
+    template <class>
+    friend class basic_romanizer_stream;
+    template <class>
+    friend class basic_romanizer_batch;
+    template <class>
+    friend class basic_romanizer_cache;
+    template <class>
+    friend class basic_romanized_view;
+    template <class>
+    friend class basic_romanization_fingerprinter;
 public:
  /**
-  * Romanizes a Hangul string using the Revised Romanization of Korean system while leaving non-Hangul and incomplete Hangul characters untouched.
+  * Romanizes a Hangul string using the romanization system while leaving non-Hangul and incomplete Hangul characters untouched.
   *
   * @param s The Hangul string to be romanized.
   * @return The romanization of the Hangul string.
-  * @see <a href="https://www.korean.go.kr/front_eng/roman/roman_01.do">Revised Romanization of Korean system transcription summary</a>
   */
- static std::string romanize(const std::string& s);
-};
+ static std::string romanize(std::string_view s);
+ /**
+  * Romanizes a Hangul string like @link romanize(std::string_view) @endlink, appending the romanization to an existing string.
+  *
+  * The string grows at most once, so reusing it across calls avoids heap allocations once its capacity suffices.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param result The string the romanization of the Hangul string is appended to.
+  */
+ static void romanize(std::string_view s, std::string& result);
+ /**
+  * Romanizes a Hangul string like @link romanize(std::string_view) @endlink, writing the romanization to a caller-owned buffer.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param result The buffer the romanization is written to, which must have room for at least
+  * @link max_romanized_size @endlink<code>(s.size())</code> bytes.
+  * @return The amount of bytes written to <code>result</code>.
+  */
+ static std::size_t romanize(std::string_view s, char* result);
+ /**
+  * Romanizes a Hangul string like @link romanize(std::string_view, std::string&) @endlink, also recording which part of the romanization
+  * every character of the string was romanized into, in the same pass.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param result The string the romanization of the Hangul string is appended to.
+  * @param offsets The map the offsets are recorded in, replacing its previous contents. Offsets into the romanization
+  * start at the end of <code>result</code> before the call.
+  */
+ static void romanize(std::string_view s, std::string& result, korean_romanizer_offset_map& offsets);
+ /**
+  * Romanizes a Hangul string like @link romanize(std::string_view) @endlink, romanizing the words of a dictionary as the dictionary says.
+  *
+  * Wherever a word starts, that is at a Hangul character not preceded by another, the longest word of the dictionary it starts with
+  * is replaced by its romanization. The Hangul character following the word starts a word itself, so it can begin another word of the dictionary.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param dictionary The dictionary of words whose romanizations override the pronunciation rules.
+  * @return The romanization of the Hangul string.
+  */
+ static std::string romanize(std::string_view s, const korean_romanizer_dictionary& dictionary);
+ /**
+  * Romanizes a Hangul string like @link romanize(std::string_view, const korean_romanizer_dictionary&) @endlink,
+  * appending the romanization to an existing string.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param result The string the romanization of the Hangul string is appended to.
+  * @param dictionary The dictionary of words whose romanizations override the pronunciation rules.
+  */
+ static void romanize(std::string_view s, std::string& result, const korean_romanizer_dictionary& dictionary);
+ /**
+  * Romanizes a Hangul string like @link romanize(std::string_view, std::string&) @endlink, handling bytes that are not valid UTF-8
+  * as the error policy says instead of throwing, unless the policy is to throw.
+  *
+  * Errors are detected in the same pass that romanizes the string, so invalid input costs about as much as valid input.
+  * An error ends the word before it, just like any other character that is not Hangul.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param result The string the romanization of the Hangul string is appended to.
+  * @param policy What to do with bytes that are not valid UTF-8.
+  * @return The amount of errors and the offset of the first one.
+  * @throws std::range_error If the policy is @link korean_romanizer_error_policy::throw_exception @endlink and the string is not valid UTF-8.
+  */
+ static korean_romanizer_result romanize(std::string_view s, std::string& result, korean_romanizer_error_policy policy);
+ /**
+  * Romanizes a Hangul string like @link romanize(std::string_view) @endlink, splitting it into chunks that are romanized on separate threads.
+  *
+  * Strings too short to benefit from multiple threads are romanized on the calling thread.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param thread_count The maximum amount of threads to use, or <code>0</code> to use one per hardware thread.
+  * @return The romanization of the Hangul string.
+  */
+ static std::string romanize_parallel(std::string_view s, unsigned thread_count = 0);
+ /**
+  * Romanizes a Hangul string like @link romanize_parallel(std::string_view, unsigned) @endlink, appending the romanization to an existing string.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param result The string the romanization of the Hangul string is appended to.
+  * @param thread_count The maximum amount of threads to use, or <code>0</code> to use one per hardware thread.
+  */
+ static void romanize_parallel(std::string_view s, std::string& result, unsigned thread_count = 0);
+ /**
+  * The minimum length of a chunk @link romanize_parallel(std::string_view, std::string&, unsigned) @endlink romanizes on its own thread, in bytes.
+  */
+ static constexpr std::size_t min_parallel_chunk_size = 1 << 16;
+ /**
+  * Calculates the size of a buffer that can hold the romanization of a string.
+  *
+  * Every Hangul character takes three bytes in UTF-8 and is romanized into at most
+  * @link korean_character::pronunciation_table::max_length @endlink bytes, while every other byte is left untouched.
+  * As romanizations are written @link korean_character::pronunciation_table::copy_length @endlink bytes at a time,
+  * the buffer also needs room for that many bytes past the end of the romanization.
+  *
+  * @param size The length of the string to be romanized, in bytes.
+  * @return The required size of the buffer, in bytes.
+  */
+ static constexpr std::size_t max_romanized_size(const std::size_t size) {
+     return size / 3 * korean_character::pronunciation_table<System>::max_length + size % 3 + korean_character::pronunciation_table<System>::copy_length;
+ }
+#if __cpp_nontype_template_args >= 201911L
+ /**
+  * Romanizes a Hangul string literal like @link romanize(std::string_view) @endlink at compile time, using the same rule tables.
+  *
+  * The romanization is stored in static storage, so calling this at runtime costs nothing.
+  * Literals that are not valid UTF-8 fail to compile.
+  *
+  * @tparam s The Hangul string literal to be romanized, such as <code>korean_romanizer::romanize_literal<"서울">()</code>.
+  * @return The romanization of the Hangul string literal.
+  */
+ template <korean_fixed_string s>
+ static constexpr std::string_view romanize_literal();
+#endif
+private:
+ /**
+  * Decodes the UTF-8 sequence at the start of a string, advancing past it.
+  *
+  * Overlong sequences, surrogates, code points above U+10FFFF and truncated sequences are rejected.
+  *
+  * @param begin The start of the string, which is moved to the end of the decoded sequence.
+  * @param end The end of the string, which must differ from <code>begin</code>.
+  * @return The decoded code point.
+  * @throws std::range_error If the string does not start with a valid UTF-8 sequence.
+  */
+ static char32_t decode_character(const char*& begin, const char* end);
+ /**
+  * Finds the first byte of a string that is not ASCII, scanning 32 bytes at a time with AVX2 or 16 bytes at a time with SSE2
+  * depending on what the processor supports, or 8 bytes at a time elsewhere.
+  *
+  * @param begin The start of the string.
+  * @param end The end of the string.
+  * @return The first byte that is not ASCII, or <code>end</code> if there is none.
+  */
+ static const char* find_non_ascii(const char* begin, const char* end);
+ /**
+  * Romanizes a string whose preceding characters have already been romanized, except for the last Hangul character,
+  * which might be affected by the characters following it.
+  *
+  * @param begin The start of the string.
+  * @param end The end of the string, which must not cut a UTF-8 sequence in half.
+  * @param result The buffer the romanization is written to, which must have room for at least
+  * @link max_romanized_size @endlink bytes for the string and the pending character together.
+  * @param previous_character The character preceding the pending character, which is updated for the next call.
+  * @param pending_character The last Hangul character that has not been romanized yet, or a character that is not Hangul if there is none,
+  * which is updated for the next call.
+  * @param offsets Records the length of everything written to <code>result</code>, such as a @link korean_romanizer_offset_map @endlink,
+  * or an object whose recording functions do nothing and are compiled away.
+  * @param dictionary Matches the words that start in the string, such as a @link korean_romanizer_dictionary @endlink,
+  * or an object that never matches and is compiled away.
+  * @param errors Handles bytes that are not valid UTF-8 according to a @link korean_romanizer_error_policy @endlink,
+  * or an object that leaves them to throw, in which case handling them is compiled away.
+  * The buffer then needs room for three bytes for every byte of the string in case every byte is replaced.
+  * @return The end of the romanization written to <code>result</code>.
+  * @throws std::range_error If the string is not valid UTF-8 and errors are left to throw.
+  */
+ template <class Offsets, class Dictionary, class Errors>
+ static char* romanize(const char* begin, const char* end, char* result, korean_character& previous_character, korean_character& pending_character, Offsets& offsets, const Dictionary& dictionary, Errors& errors);
+ /**
+  * Records a Hangul character decoded from the given amount of bytes, which are three bytes for every jamo it was composed of,
+  * as its romanization followed by nothing for every later jamo.
+  *
+  * @param offsets Records the lengths.
+  * @param size The length of the romanization of the Hangul character.
+  * @param source_size The length of the Hangul character in the string.
+  */
+ template <class Offsets>
+ static void record_syllable(Offsets& offsets, std::size_t size, std::size_t source_size);
+ /**
+  * Romanizes the pending character left behind by @link romanize(const char*, const char*, char*, korean_character&, korean_character&, Offsets&, const Dictionary&, Errors&) @endlink
+  * as the last character of the string, resetting both characters.
+  *
+  * @param previous_character The character preceding the pending character.
+  * @param pending_character The pending character.
+  * @param result The buffer the romanization is written to.
+  * @param offsets Records the length of the romanization of the pending character.
+  * @return The end of the romanization written to <code>result</code>.
+  */
+ template <class Offsets>
+ static char* finish(korean_character& previous_character, korean_character& pending_character, char* result, Offsets& offsets);
+ /**
+  * Counts Hangul characters romanized by the romanization loop, and how many of their consonants the context changed,
+  * if the library is compiled with <code>KOREAN_ROMANIZER_METRICS</code> defined.
+  *
+  * @param window The character preceding the characters, the characters, and the character following them.
+  * @param count The amount of characters.
+  */
+ static void count_romanized(const korean_character* window, std::size_t count);
+ /**
+  * The amount of Hangul characters @link romanize(std::string_view, char*) @endlink decodes at once.
+  */
+ static constexpr std::size_t hangul_block_size = 64;
+ /**
+  * Decodes the run of Hangul characters at the start of a string into their packed jamo indices,
+  * validating and decomposing 16 characters at a time with AVX2 or 8 characters at a time with SSE4.1
+  * depending on what the processor supports, or one character at a time elsewhere.
+  *
+  * @param begin The start of the string, which is moved to the end of the decoded characters.
+  * @param end The end of the string.
+  * @param result The buffer the decoded characters are written to.
+  * @param capacity The maximum amount of characters to decode.
+  * @return The amount of characters decoded, which is <code>0</code> if the string does not start with a Hangul character.
+  */
+ static std::size_t decode_hangul(const char*& begin, const char* end, korean_character* result, std::size_t capacity);
+ /**
+  * Decodes the run of Hangul characters at the start of a string like @link decode_hangul @endlink,
+  * also composing the conjoining jamo of decomposed (NFD) text into the Hangul characters they spell.
+  *
+  * As in canonical composition, a leading consonant followed by a vowel, and optionally a trailing consonant, makes up a Hangul character,
+  * and a trailing consonant following a Hangul character without one is added to it.
+  *
+  * @param begin The start of the string, which is moved to the end of the decoded characters.
+  * @param end The end of the string.
+  * @param result The buffer the decoded characters are written to, preceded by the character before the string,
+  * which a trailing consonant at the start of the string is added to.
+  * @param capacity The maximum amount of characters to decode.
+  * @param source_sizes The buffer the length of every decoded character in bytes is written to, preceded by that of the character
+  * before the string, or <code>nullptr</code> if the lengths are not needed.
+  * @return The amount of characters decoded, which is <code>0</code> if the string does not start with a Hangul character.
+  */
+ static std::size_t decode_syllables(const char*& begin, const char* end, korean_character* result, std::size_t capacity, unsigned char* source_sizes);
+ /**
+  * Decodes the UTF-8 sequence at a position of a string like @link decode_character @endlink, in a constant expression.
+  *
+  * @param s The string.
+  * @param i The position of the sequence, which is moved to the end of the decoded sequence.
+  * @return The decoded code point.
+  */
+ static constexpr char32_t decode_constant(std::string_view s, std::size_t& i);
+ /**
+  * Romanizes a Hangul string like @link romanize(std::string_view, char*) @endlink, in a constant expression.
+  *
+  * @param s The Hangul string to be romanized.
+  * @param result The buffer the romanization is written to, or <code>nullptr</code> to only calculate its length.
+  * @return The length of the romanization.
+  */
+ static constexpr std::size_t romanize_constant(std::string_view s, char* result);
+#if __cpp_nontype_template_args >= 201911L
+ /**
+  * @brief Holds the romanization of a string literal, which is generated at compile time.
+  * @details Defined below @link korean_romanizer @endlink, as the romanization can only be generated once the class is complete.
+  */
+ template <korean_fixed_string s>
+ struct literal_romanization;
+#endif
+};
+template <class System>
+constexpr char32_t basic_romanizer<System>::decode_constant(const std::string_view s, std::size_t& i) {
+    const auto byte = [s](const std::size_t j) { return static_cast<unsigned char>(s[j]); };
+    const unsigned char lead = byte(i);
+    const std::size_t length = lead < 0x80 ? 1 : lead >= 0xC2 && lead <= 0xDF ? 2 : lead >= 0xE0 && lead <= 0xEF ? 3 : lead >= 0xF0 && lead <= 0xF4 ? 4 : 0;
+    if (!length || s.size() - i < length)
+        throw "invalid UTF-8 sequence";
+    char32_t c = length == 1 ? lead : lead & (0x7F >> length);
+    for (std::size_t j = 1; j < length; ++j) {
+        if ((byte(i + j) & 0xC0) != 0x80)
+            throw "invalid UTF-8 sequence";
+        c = c << 6 | (byte(i + j) & 0x3F);
+    }
+    constexpr char32_t min[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (c < min[length] || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        throw "invalid UTF-8 sequence";
+    i += length;
+    return c;
+}
+template <class System>
+constexpr std::size_t basic_romanizer<System>::romanize_constant(const std::string_view s, char* const result) {
+    using table = korean_character::pronunciation_table<System>;
+    const auto is_korean_character = [](const char32_t c) {
+        return c >= korean_character::character_min && c < korean_character::character_min + korean_character::all_jamo_combination_count;
+    };
+    std::size_t size = 0;
+    const auto write = [&size, result](const std::string_view romanization) {
+        for (const char c : romanization) {
+            if (result)
+                result[size] = c;
+            ++size;
+        }
+    };
+    const auto write_entry = [&write](const typename table::entry e) { write(table::blob.substr(e.offset, e.length)); };
+    // conjoining jamo spelling a Hangul character are composed into it, as at runtime
+    const auto decode_syllable = [s, is_korean_character](std::size_t& i) {
+        char32_t c = decode_constant(s, i);
+        const auto next_jamo = [s, &i](const char32_t min, const int count) {
+            std::size_t j = i;
+            if (j == s.size())
+                return -1;
+            const char32_t n = decode_constant(s, j);
+            if (n < min || n >= min + count)
+                return -1;
+            i = j;
+            return static_cast<int>(n - min);
+        };
+        if (c >= korean_character::leading_consonant_jamo_min && c < korean_character::leading_consonant_jamo_min + korean_character::leading_consonant_jamo_count) {
+            const int vowel = next_jamo(korean_character::vowel_jamo_min, korean_character::vowel_jamo_count);
+            if (vowel < 0)
+                return c;
+            c = korean_character::character_min + (c - korean_character::leading_consonant_jamo_min) * korean_character::vowel_and_trailing_consonant_jamo_combination_count
+                + vowel * korean_character::trailing_consonant_jamo_count;
+        }
+        if (is_korean_character(c) && (c - korean_character::character_min) % korean_character::trailing_consonant_jamo_count == 0) {
+            if (const int trailing_consonant = next_jamo(korean_character::trailing_consonant_jamo_min + 1, korean_character::trailing_consonant_jamo_count - 1); trailing_consonant >= 0)
+                c += trailing_consonant + 1;
+        }
+        return c;
+    };
+    int previous_trailing_consonant = korean_character::trailing_consonant_jamo_count;
+    for (std::size_t i = 0; i < s.size();) {
+        const std::size_t begin = i;
+        const char32_t c = decode_syllable(i);
+        if (!is_korean_character(c)) {
+            write(s.substr(begin, i - begin));
+            previous_trailing_consonant = korean_character::trailing_consonant_jamo_count;
+            continue;
+        }
+        int next_leading_consonant = korean_character::leading_consonant_jamo_count;
+        if (std::size_t next = i; next < s.size()) {
+            if (const char32_t n = decode_syllable(next); is_korean_character(n))
+                next_leading_consonant = (n - korean_character::character_min) / korean_character::vowel_and_trailing_consonant_jamo_combination_count;
+        }
+        const int index = c - korean_character::character_min;
+        const int trailing_consonant = index % korean_character::trailing_consonant_jamo_count;
+        write_entry(table::leading_consonants[previous_trailing_consonant][index / korean_character::vowel_and_trailing_consonant_jamo_combination_count]);
+        write_entry(table::vowels[index / korean_character::trailing_consonant_jamo_count % korean_character::vowel_jamo_count]);
+        write_entry(table::trailing_consonants[trailing_consonant][next_leading_consonant]);
+        previous_trailing_consonant = trailing_consonant;
+    }
+    return size;
+}
+#if __cpp_nontype_template_args >= 201911L
+template <class System>
+template <korean_fixed_string s>
+struct basic_romanizer<System>::literal_romanization {
+    /**
+     * The length of the romanization.
+     */
+    static constexpr std::size_t size = romanize_constant(s.view(), nullptr);
+    /**
+     * The romanization.
+     */
+    static constexpr std::array<char, size> romanization = [] {
+        std::array<char, size> r{};
+        romanize_constant(s.view(), r.data());
+        return r;
+    }();
+};
+template <class System>
+template <korean_fixed_string s>
+constexpr std::string_view basic_romanizer<System>::romanize_literal() {
+    return std::string_view(literal_romanization<s>::romanization.data(), literal_romanization<s>::size);
+}
+#endif
+/**
+ * @brief Romanizes Hangul strings using the Revised Romanization of Korean system.
+ */
+using korean_romanizer = basic_romanizer<revised_romanization>;
+extern template class basic_romanizer<revised_romanization>;
+extern template class basic_romanizer<mccune_reischauer>;
+
+/**
+ * @brief Romanizes a Hangul string that arrives in chunks, such as from a socket or a pipe.
+ * @details Chunks may be split anywhere, including in the middle of a UTF-8 sequence.
+ * At most one incomplete UTF-8 sequence, a conjoining leading consonant and one Hangul character are held back between chunks,
+ * so the memory used does not depend on the size of the string.
+ * The concatenated output is identical to romanizing the whole string with @link basic_romanizer::romanize @endlink.
+ *
+ * @tparam System The romanization system.
+ */
+template <class System>
+class basic_romanizer_stream {
+    /**
+     * The start of a UTF-8 sequence that was cut off at the end of the last chunk, preceded by a conjoining leading consonant
+     * if one ended the chunk, as the vowel it might be composed with has not arrived yet.
+     */
+    char partial_sequence[7]{};
+    /**
+     * The amount of bytes in @link partial_sequence @endlink.
+     */
+    std::size_t partial_sequence_size = 0;
+    /**
+     * The character preceding @link pending_character @endlink.
+     */
+    korean_character previous_character;
+    /**
+     * The last Hangul character, which cannot be romanized until the character following it has been decoded.
+     */
+    korean_character pending_character;
+public:
+    /**
+     * Romanizes the next chunk of the string, appending as much of the romanization as can be determined so far to a string.
+     *
+     * @param chunk The next chunk of the string.
+     * @param result The string the romanization is appended to.
+     * @throws std::range_error If the string is not valid UTF-8, after which the stream must not be used anymore.
+     */
+    void feed(std::string_view chunk, std::string& result);
+    /**
+     * Appends the rest of the romanization to a string, after which the stream can be used for a new string.
+     *
+     * @param result The string the romanization is appended to.
+     * @throws std::range_error If the string ends in the middle of a UTF-8 sequence, after which the stream can also be used for a new string.
+     */
+    void finish(std::string& result);
+};
+/**
+ * @brief Romanizes a Hangul string that arrives in chunks using the Revised Romanization of Korean system.
+ */
+using korean_romanizer_stream = basic_romanizer_stream<revised_romanization>;
+extern template class basic_romanizer_stream<revised_romanization>;
+extern template class basic_romanizer_stream<mccune_reischauer>;
+
+/**
+ * @brief Romanizes many strings at once, storing their romanizations back to back in a single buffer.
+ * @details The layout matches an Apache Arrow large string column: romanization <code>i</code> is the range of @link data @endlink
+ * between <code>offsets()[i]</code> and <code>offsets()[i + 1]</code>.
+ * Reusing an instance for the next batch reuses its buffers, so no heap allocations are made once they are large enough.
+ *
+ * @tparam System The romanization system.
+ */
+template <class System>
+class basic_romanizer_batch {
+    /**
+     * The romanizations of every string, back to back.
+     */
+    std::string romanizations;
+    /**
+     * The start of every romanization in @link romanizations @endlink, followed by the end of the last one.
+     */
+    std::vector<std::int64_t> romanization_offsets{0};
+public:
+    /**
+     * Romanizes a batch of strings like @link basic_romanizer::romanize(std::string_view) @endlink, replacing the previous batch.
+     *
+     * @param strings The Hangul strings to be romanized.
+     * @param count The amount of strings.
+     * @param thread_count The maximum amount of threads to split the strings between, or <code>0</code> to use one per hardware thread.
+     * Batches too small to benefit from multiple threads are romanized on the calling thread.
+     * @throws std::range_error If a string is not valid UTF-8.
+     */
+    void romanize(const std::string_view* strings, std::size_t count, unsigned thread_count = 1);
+    /**
+     * @return The amount of romanizations in the batch.
+     */
+    std::size_t size() const { return romanization_offsets.size() - 1; }
+    /**
+     * @return The romanization of the string at the given index.
+     */
+    std::string_view operator[](const std::size_t i) const {
+        return std::string_view(romanizations).substr(romanization_offsets[i], romanization_offsets[i + 1] - romanization_offsets[i]);
+    }
+    /**
+     * @return The romanizations of every string, back to back.
+     */
+    const std::string& data() const { return romanizations; }
+    /**
+     * @return The start of every romanization in @link data @endlink, followed by the end of the last one.
+     */
+    const std::vector<std::int64_t>& offsets() const { return romanization_offsets; }
+};
+/**
+ * @brief Romanizes many strings at once using the Revised Romanization of Korean system.
+ */
+using korean_romanizer_batch = basic_romanizer_batch<revised_romanization>;
+extern template class basic_romanizer_batch<revised_romanization>;
+extern template class basic_romanizer_batch<mccune_reischauer>;
+
+/**
+ * @brief Romanizes strings like @link basic_romanizer::romanize @endlink, remembering the romanizations of recently seen words.
+ * @details A word is a run of Hangul characters between characters that are not Hangul, which never affect its romanization,
+ * so a word found in the cache is appended without being decomposed and romanized again.
+ * Every word is cached inline in one of a few slots chosen by its hash, guarded by a sequence number,
+ * so lookups take no lock and count as a miss if the slot they read is changed at the same time.
+ * The cache is split into shards, each with its own lock, which only insertions take.
+ * Once the slots of a word are full, their least recently used words are evicted with the CLOCK policy.
+ * A single instance can be used from many threads at once.
+ *
+ * @tparam System The romanization system.
+ */
+template <class System>
+class basic_romanizer_cache {
+    /**
+     * @brief Holds a part of the cached words, chosen by their hashes.
+     * @details Defined in the source file, as it is an implementation detail.
+     */
+    struct shard;
+    /**
+     * The amount of 64-bit words a cached word is compared and stored in.
+     */
+    static constexpr std::size_t key_size = 4;
+    /**
+     * The shards of the cache.
+     */
+    std::unique_ptr<shard[]> shards;
+    /**
+     * The amount of shards in @link shards @endlink.
+     */
+    std::size_t shard_count;
+public:
+    /**
+     * The length of the longest word that is cached, in bytes, which fits words of up to 10 Hangul characters.
+     * Longer words, and words with romanizations too long for their slot, are romanized every time.
+     */
+    static constexpr std::size_t max_word_size = key_size * 8;
+    /**
+     * Creates an empty cache.
+     *
+     * @param capacity The maximum amount of words to cache, rounded down to whole buckets of 4 slots in every shard, with at least one bucket per shard.
+     * Every slot takes 128 bytes.
+     * @param shard_count The amount of shards to split the cache into, which bounds the amount of threads that can insert words at once.
+     */
+    explicit basic_romanizer_cache(std::size_t capacity = 1 << 16, std::size_t shard_count = 16);
+    ~basic_romanizer_cache();
+    /**
+     * Romanizes a Hangul string like @link basic_romanizer::romanize(std::string_view) @endlink, looking up every word in the cache.
+     *
+     * @param s The Hangul string to be romanized.
+     * @return The romanization of the Hangul string.
+     * @throws std::range_error If the string is not valid UTF-8.
+     */
+    std::string romanize(std::string_view s);
+    /**
+     * Romanizes a Hangul string like @link romanize(std::string_view) @endlink, appending the romanization to an existing string.
+     *
+     * @param s The Hangul string to be romanized.
+     * @param result The string the romanization of the Hangul string is appended to.
+     * @throws std::range_error If the string is not valid UTF-8, in which case <code>result</code> is left unchanged.
+     */
+    void romanize(std::string_view s, std::string& result);
+    /**
+     * @return The amount of words that were found in the cache.
+     */
+    std::uint64_t hits() const;
+    /**
+     * @return The amount of words that were not found in the cache, excluding words longer than @link max_word_size @endlink.
+     */
+    std::uint64_t misses() const;
+    /**
+     * @return The amount of words in the cache.
+     */
+    std::size_t size() const;
+    /**
+     * Removes every word from the cache, keeping the @link hits @endlink and @link misses @endlink counters.
+     */
+    void clear();
+};
+/**
+ * @brief Romanizes strings using the Revised Romanization of Korean system, remembering the romanizations of recently seen words.
+ */
+using korean_romanizer_cache = basic_romanizer_cache<revised_romanization>;
+extern template class basic_romanizer_cache<revised_romanization>;
+extern template class basic_romanizer_cache<mccune_reischauer>;
+
+/**
+ * Hashes a string with 64-bit FNV-1a, continuing from the hash of the strings before it.
+ *
+ * @link basic_romanized_view::hash @endlink hashes a romanization piece by piece with this function,
+ * so hashing a stored romanization with it gives the same hash.
+ *
+ * @param s The string to be hashed.
+ * @param hash The hash of the strings before it, or the FNV offset basis to start a new hash.
+ * @return The hash of the strings and <code>s</code> together.
+ */
+constexpr std::uint64_t korean_romanization_hash(const std::string_view s, std::uint64_t hash = 0xCBF29CE484222325) {
+    for (const char c : s)
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3;
+    return hash;
+}
+
+/**
+ * @brief Romanizes a string lazily, as a range of pieces of its romanization, such as for hashing or comparing it without storing it.
+ * @details Iterating over the view runs the same romanization loop as @link basic_romanizer::romanize @endlink on a few dozen bytes of the string at a time,
+ * writing every piece to a buffer inside the iterator, so it never allocates. The pieces put together are the romanization of the string.
+ * @link hash @endlink, @link compare @endlink and @link size @endlink are built on top of it, and @link compare @endlink stops at the first piece that differs.
+ * The view only refers to the string, which must outlive it.
+ *
+ * @tparam System The romanization system.
+ */
+template <class System>
+class basic_romanized_view {
+    std::string_view source;
+public:
+    /**
+     * @brief The end of a @link basic_romanized_view @endlink.
+     */
+    struct sentinel {};
+    /**
+     * @brief Iterates over the pieces of a romanization, each valid until the iterator is advanced.
+     */
+    class iterator {
+        friend class basic_romanized_view;
+        /**
+         * The amount of bytes of the string romanized per piece, which is extended to the end of a character.
+         */
+        static constexpr std::size_t chunk_size = 64;
+        const char* position = nullptr;
+        const char* end = nullptr;
+        korean_character previous_character;
+        korean_character pending_character;
+        std::size_t piece_size = 0;
+        /**
+         * Whether the pending character has been romanized after the end of the string.
+         */
+        bool finished = true;
+        /**
+         * The current piece, with room for a chunk extended to the end of a character and past a vowel jamo, and the pending character before it.
+         */
+        char piece[basic_romanizer<System>::max_romanized_size(chunk_size + 9)];
+        explicit iterator(std::string_view s);
+        /**
+         * Romanizes chunks until one produces a piece, or the end of the string is reached.
+         *
+         * @throws std::range_error If the string is not valid UTF-8.
+         */
+        void advance();
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+        /**
+         * Creates an iterator at the end of an empty string.
+         */
+        iterator() = default;
+        std::string_view operator*() const { return std::string_view(piece, piece_size); }
+        /**
+         * @throws std::range_error If the string is not valid UTF-8.
+         */
+        iterator& operator++() {
+            advance();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator copy = *this;
+            advance();
+            return copy;
+        }
+        friend bool operator==(const iterator& i, sentinel) { return !i.piece_size; }
+        friend bool operator==(sentinel, const iterator& i) { return !i.piece_size; }
+        friend bool operator!=(const iterator& i, sentinel) { return i.piece_size; }
+        friend bool operator!=(sentinel, const iterator& i) { return i.piece_size; }
+    };
+    /**
+     * Creates a view of the romanization of an empty string.
+     */
+    basic_romanized_view() = default;
+    /**
+     * Creates a view of the romanization of a string, without romanizing it yet.
+     *
+     * @param s The Hangul string to be romanized.
+     */
+    explicit basic_romanized_view(const std::string_view s) : source(s) {}
+    /**
+     * Romanizes the first piece of the string.
+     *
+     * @throws std::range_error If the string is not valid UTF-8.
+     */
+    iterator begin() const { return iterator(source); }
+    sentinel end() const { return {}; }
+    /**
+     * @return The length of the romanization, in bytes.
+     * @throws std::range_error If the string is not valid UTF-8.
+     */
+    std::size_t size() const;
+    /**
+     * @return The hash of the romanization, which is @link korean_romanization_hash @endlink of the romanized string.
+     * @throws std::range_error If the string is not valid UTF-8.
+     */
+    std::uint64_t hash() const;
+    /**
+     * Compares the romanization with a string lexicographically, byte by byte, like <code>std::string_view::compare</code>,
+     * stopping at the first piece that differs.
+     *
+     * @param latin The string to be compared with, such as a stored romanization.
+     * @return A negative value if the romanization comes before <code>latin</code>, <code>0</code> if they are equal, and a positive value otherwise.
+     * @throws std::range_error If the string is not valid UTF-8 up to where the romanization differs.
+     */
+    int compare(std::string_view latin) const;
+};
+/**
+ * @brief Romanizes a string lazily using the Revised Romanization of Korean system.
+ */
+using korean_romanized_view = basic_romanized_view<revised_romanization>;
+extern template class basic_romanized_view<revised_romanization>;
+extern template class basic_romanized_view<mccune_reischauer>;
+
+/**
+ * @brief Maps byte offsets of a string to byte offsets of its romanization and back, such as for highlighting search results.
+ * @details Filled by @link basic_romanizer::romanize(std::string_view, std::string&, korean_romanizer_offset_map&) @endlink.
+ * Characters that are left untouched are stored as runs, and Hangul characters as the lengths of their romanizations,
+ * one byte each, so the map is much smaller than the string.
+ * A Hangul character composed of conjoining jamo is stored as three bytes per jamo, all but the first romanized into nothing,
+ * so the offsets of its later jamo map to the end of its romanization.
+ */
+class korean_romanizer_offset_map {
+    template <class System>
+    friend class basic_romanizer;
+    /**
+     * @brief A run of characters that are left untouched, or of Hangul characters.
+     */
+    struct segment {
+        std::size_t source_offset;
+        std::size_t romanization_offset;
+        /**
+         * The index of the romanization length of the first Hangul character in @link syllable_lengths @endlink.
+         */
+        std::size_t first_syllable;
+        /**
+         * The amount of Hangul characters, or <code>0</code> if the characters are left untouched.
+         */
+        std::size_t syllable_count;
+    };
+    /**
+     * The maximum amount of Hangul characters in a segment, which bounds the work of a lookup inside it.
+     */
+    static constexpr std::size_t max_segment_syllables = 64;
+    std::vector<segment> segments;
+    /**
+     * The length of the romanization of every Hangul character.
+     */
+    std::vector<unsigned char> syllable_lengths;
+    std::size_t source_size = 0;
+    std::size_t romanization_size = 0;
+    /**
+     * The length in bytes of the Hangul character left pending by the last block of the romanization loop, which is not recorded until it is romanized.
+     */
+    std::size_t pending_source_size = 3;
+    /**
+     * Removes every offset, so that a new string can be recorded.
+     */
+    void clear();
+    /**
+     * Records characters of the given size that were left untouched.
+     */
+    void record_copy(std::size_t size);
+    /**
+     * Records a Hangul character that was romanized into the given amount of bytes.
+     */
+    void record_syllable(std::size_t size);
+public:
+    /**
+     * Finds where the romanization of a character starts.
+     *
+     * @param source_offset The offset of a character in the string, in bytes.
+     * Offsets at or past the end of the string map to the end of the romanization.
+     * @return The offset of the romanization of the character in the romanization of the string, in bytes.
+     * Offsets inside a Hangul character map to the start of its romanization, and offsets inside untouched characters map to the same byte.
+     */
+    std::size_t to_romanization(std::size_t source_offset) const;
+    /**
+     * Finds the character a byte of the romanization was romanized from.
+     *
+     * @param romanization_offset The offset of a byte in the romanization of the string.
+     * Offsets at or past the end of the romanization map to the end of the string.
+     * @return The offset of the character in the string, in bytes.
+     */
+    std::size_t to_source(std::size_t romanization_offset) const;
+    /**
+     * @return The length of the string, in bytes.
+     */
+    std::size_t source_length() const { return source_size; }
+    /**
+     * @return The length of the romanization, in bytes.
+     */
+    std::size_t romanization_length() const { return romanization_size; }
+};
+
+/**
+ * @brief Overrides the romanization of words the pronunciation rules get wrong, such as proper nouns like 신문로.
+ * @details Words are stored in a double-array trie over the indices of their Hangul characters, split into their high and low seven bits
+ * so that the children of a node are close together. Matching a word costs two array lookups per character.
+ * Before the trie is searched, a Bloom filter of the first two characters of every word, taking about two bytes per word,
+ * rules out nearly every word that is not in the dictionary, so a string without any costs about one memory access per word.
+ *
+ * A dictionary is built from pairs of words and romanizations, or from a text file, and can be saved as a binary image,
+ * which is memory-mapped when loaded so that even large dictionaries are ready at once. Copies share the same storage.
+ */
+class korean_romanizer_dictionary {
+    template <class System>
+    friend class basic_romanizer;
+    /**
+     * @brief A node of the trie, whose children are found at <code>base</code> plus their half of the index of a Hangul character.
+     */
+    struct cell {
+        std::int32_t base;
+        /**
+         * The parent of the node, or <code>-1</code> if the cell is not a node.
+         */
+        std::int32_t check;
+        /**
+         * The index of the romanization of the word ending at the node, or <code>-1</code> if no word ends there.
+         */
+        std::int32_t value;
+    };
+    /**
+     * @brief The start of a binary image, which is followed by the filters, the cells of the trie, the offsets of the romanizations
+     * and the romanizations.
+     */
+    struct header {
+        char magic[8];
+        /**
+         * @link byte_order_mark @endlink as written by the machine that saved the image.
+         */
+        std::uint32_t byte_order;
+        /**
+         * The length of the longest romanization divided by the length of its word, rounded up.
+         */
+        std::uint32_t max_length_per_syllable;
+        /**
+         * The size of @link pair_filter @endlink in 64-bit words, which is a power of two.
+         */
+        std::uint64_t pair_filter_size;
+        std::uint64_t cell_count;
+        std::uint64_t word_count;
+        std::uint64_t romanizations_size;
+        /**
+         * The length of the shortest word in Hangul characters, or one more than @link max_word_syllables @endlink if there are no words.
+         */
+        std::uint64_t min_word_syllables;
+    };
+    static constexpr char magic[8] = {'K', 'R', 'D', 'I', 'C', 'T', '0', '4'};
+    static constexpr std::uint32_t byte_order_mark = 0x01020304;
+    /**
+     * The size of @link single_character_filter @endlink in 64-bit words, with a bit for the packed jamo of every Hangul character.
+     */
+    static constexpr std::size_t single_character_filter_size = (korean_character::leading_consonant_jamo_count << 10) / 64;
+    /**
+     * The amount of bits of a 64-bit word of @link pair_filter @endlink that are set for every word.
+     */
+    static constexpr int pair_filter_bit_count = 4;
+    /**
+     * The 64-bit word of @link pair_filter @endlink for the packed jamo of the first two Hangul characters of a word,
+     * chosen by the high bits of a hash that a shift of @link pair_filter_shift @endlink leaves.
+     */
+    static std::size_t pair_filter_word(const unsigned first, const unsigned second, const unsigned shift) {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(first) << 16 | second) * 0x9E3779B97F4A7C15 >> shift);
+    }
+    /**
+     * The bits of a 64-bit word of @link pair_filter @endlink that are set for the packed jamo of the first two Hangul characters of a word,
+     * chosen by six high bits each of a second hash.
+     */
+    static std::uint64_t pair_filter_mask(const unsigned first, const unsigned second) {
+        const std::uint64_t hash = (static_cast<std::uint64_t>(first) << 16 | second) * 0xC2B2AE3D27D4EB4F;
+        std::uint64_t mask = 0;
+        for (int i = 0; i < pair_filter_bit_count; ++i)
+            mask |= std::uint64_t{1} << (hash >> (58 - 6 * i) & 63);
+        return mask;
+    }
+    /**
+     * The binary image, which is either owned or memory-mapped.
+     */
+    std::shared_ptr<const char> image;
+    std::size_t image_size = 0;
+    /**
+     * A bit for the packed jamo of every Hangul character, which is set if the character is a word of the dictionary by itself.
+     */
+    const std::uint64_t* single_character_filter = nullptr;
+    /**
+     * A Bloom filter of the first two Hangul characters of every word that is longer than one character,
+     * which sets @link pair_filter_bit_count @endlink bits of one of its 64-bit words for every word, so that a lookup reads a single word.
+     */
+    const std::uint64_t* pair_filter = nullptr;
+    /**
+     * 64 minus the base-2 logarithm of the size of @link pair_filter @endlink in 64-bit words.
+     */
+    unsigned pair_filter_shift = 63;
+    const cell* cells = nullptr;
+    std::size_t cell_count = 0;
+    /**
+     * Where the romanization of every word starts in @link romanizations @endlink, followed by where the last one ends.
+     */
+    const std::uint32_t* romanization_offsets = nullptr;
+    const char* romanizations = nullptr;
+    std::size_t word_count = 0;
+    std::size_t max_length_per_syllable = 0;
+    /**
+     * The length of the shortest word in Hangul characters, so that shorter runs are not looked up at all.
+     */
+    std::size_t min_word_syllables = max_word_syllables + 1;
+    /**
+     * Takes over a binary image, checking its header.
+     *
+     * @throws std::runtime_error If the image is not a dictionary saved by this version of the library on a machine with the same byte order.
+     */
+    void attach(std::shared_ptr<const char> image, std::size_t size);
+    /**
+     * Starts reading the part of @link pair_filter @endlink that @link may_match @endlink reads for a run of Hangul characters,
+     * so that it can be romanized while the read is under way.
+     *
+     * @param characters The Hangul characters, followed by at least one more @link korean_character @endlink.
+     */
+    void prefetch(const korean_character* characters) const;
+    /**
+     * Checks the filters for the first characters of a run of Hangul characters, which rule out nearly every run that does not start with a word of the dictionary.
+     *
+     * @param characters The Hangul characters.
+     * @param count The amount of Hangul characters, which is at least <code>1</code>.
+     * @return <code>false</code> if the characters do not start with a word of the dictionary.
+     */
+    bool may_match(const korean_character* characters, std::size_t count) const;
+    /**
+     * Finds the longest word of the dictionary a run of Hangul characters starts with.
+     *
+     * @param characters The Hangul characters.
+     * @param count The amount of Hangul characters, which is at least <code>1</code>.
+     * @param romanization Set to the romanization of the word, if there is one.
+     * @return The length of the word in Hangul characters, or <code>0</code> if the characters do not start with a word of the dictionary.
+     */
+    std::size_t match(const korean_character* characters, std::size_t count, std::string_view& romanization) const;
+public:
+    /**
+     * The maximum length of a word, in Hangul characters.
+     */
+    static constexpr std::size_t max_word_syllables = 32;
+    /**
+     * The maximum length of a romanization, in bytes.
+     */
+    static constexpr std::size_t max_romanization_size = 255;
+    /**
+     * Creates an empty dictionary.
+     */
+    korean_romanizer_dictionary();
+    /**
+     * Creates a dictionary of words and their romanizations. If a word appears more than once, its last romanization is used.
+     *
+     * @param words The pairs of words and romanizations. Every word consists of at most @link max_word_syllables @endlink Hangul characters,
+     * and every romanization of at most @link max_romanization_size @endlink bytes.
+     * @param count The amount of pairs.
+     * @throws std::invalid_argument If a word is empty, longer than @link max_word_syllables @endlink or not made of Hangul characters,
+     * or a romanization is longer than @link max_romanization_size @endlink.
+     */
+    korean_romanizer_dictionary(const std::pair<std::string_view, std::string_view>* words, std::size_t count);
+    /**
+     * Creates a dictionary from text in which every line holds a word and its romanization, separated by spaces or tabs.
+     * Empty lines and lines starting with <code>#</code> are skipped.
+     *
+     * @param text The text.
+     * @return The dictionary.
+     * @throws std::invalid_argument If a line is malformed, naming the line.
+     */
+    static korean_romanizer_dictionary parse(std::string_view text);
+    /**
+     * Creates a dictionary from a text file like @link parse @endlink.
+     *
+     * @param path The path of the text file.
+     * @return The dictionary.
+     * @throws std::runtime_error If the file cannot be read.
+     * @throws std::invalid_argument If a line is malformed, naming the line.
+     */
+    static korean_romanizer_dictionary load_text(const std::string& path);
+    /**
+     * Loads a binary image saved by @link save @endlink, memory-mapping it where possible.
+     *
+     * Only the header of the image is checked, so only images written by @link save @endlink must be loaded.
+     *
+     * @param path The path of the binary image.
+     * @return The dictionary.
+     * @throws std::runtime_error If the file cannot be read or is not a binary image of a dictionary.
+     */
+    static korean_romanizer_dictionary load(const std::string& path);
+    /**
+     * Saves the dictionary as a binary image, which @link load @endlink can load on machines with the same byte order.
+     *
+     * @param path The path of the binary image.
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    void save(const std::string& path) const;
+    /**
+     * @return The amount of words in the dictionary.
+     */
+    std::size_t size() const { return word_count; }
+};
+
+inline void korean_romanizer_dictionary::prefetch([[maybe_unused]] const korean_character* const characters) const {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(pair_filter + pair_filter_word(characters[0].jamo, characters[1].jamo, pair_filter_shift));
+#endif
+}
+inline bool korean_romanizer_dictionary::may_match(const korean_character* const characters, const std::size_t count) const {
+    const unsigned first = characters[0].jamo;
+    if (single_character_filter[first >> 6] >> (first & 63) & 1)
+        return true;
+    if (count < 2)
+        return false;
+    const unsigned second = characters[1].jamo;
+    const std::uint64_t mask = pair_filter_mask(first, second);
+    return (pair_filter[pair_filter_word(first, second, pair_filter_shift)] & mask) == mask;
+}
+inline std::size_t korean_romanizer_dictionary::match(const korean_character* const characters, std::size_t count, std::string_view& romanization) const {
+    if (!may_match(characters, count))
+        return 0;
+    std::size_t matched = 0;
+    std::uint32_t node = 0;
+    count = count < max_word_syllables ? count : max_word_syllables;
+    for (std::size_t i = 0; i < count; ++i) {
+        const unsigned index = characters[i].index();
+        std::uint32_t next = static_cast<std::uint32_t>(cells[node].base) + (index >> 7);
+        if (next >= cell_count || cells[next].check != static_cast<std::int32_t>(node))
+            break;
+        node = next;
+        next = static_cast<std::uint32_t>(cells[node].base) + (index & 0x7F);
+        if (next >= cell_count || cells[next].check != static_cast<std::int32_t>(node))
+            break;
+        node = next;
+        if (const std::int32_t value = cells[node].value; value >= 0) {
+            matched = i + 1;
+            romanization = std::string_view(romanizations + romanization_offsets[value], romanization_offsets[value + 1] - romanization_offsets[value]);
+        }
+    }
+    return matched;
+}
+
+
+/**
+ * @brief Finds the Hangul strings a romanization could have been romanized from, such as for looking up Hangul records with a romanized query.
+ * @details Built from the same tables as @link basic_romanizer @endlink. For every trailing consonant a Hangul character can follow,
+ * a trie holds each way the character can be romanized after it: the romanization of that trailing consonant, which depends on the leading consonant,
+ * then the leading consonant and the vowel. The trailing consonant of the character itself is chosen when the next character, or the end of the query,
+ * is parsed. A query is parsed from left to right, keeping only the cheapest parses that reach each position with each trailing consonant,
+ * so the work grows with the length of the query rather than with the amount of parses, and no index of romanized words is needed.
+ *
+ * Parses are ranked by how common their jamo are, so that 신촌 comes before 씬촌 for <code>sinchon</code>.
+ * Uppercase letters are folded, and spaces, hyphens and underscores mark the boundary between two characters.
+ * The informal spellings listed by the system, such as <code>shinchon</code>, and separators that are not at a boundary are accepted at a cost.
+ * A single instance can be used from many threads at once.
+ *
+ * @tparam System The romanization system.
+ */
+template <class System>
+class basic_deromanizer {
+    /**
+     * @brief A node of a trie, whose children are stored in @link edges @endlink.
+     */
+    struct node {
+        std::uint32_t first_edge;
+        std::uint32_t edge_count;
+        /**
+         * The child reached by the boundary between two characters, which may be written as a separator, or @link no_node @endlink.
+         */
+        std::uint32_t boundary;
+        /**
+         * The leading consonants and vowels, packed as <code>leading_consonant << 5 | vowel</code> in @link values @endlink,
+         * of the characters whose romanizations end at the node.
+         */
+        std::uint32_t first_value;
+        std::uint32_t value_count;
+    };
+    struct edge {
+        char label;
+        std::uint32_t target;
+    };
+    static constexpr std::uint32_t no_node = ~std::uint32_t(0);
+    /**
+     * The amount of parses the scratch buffer of a thread keeps between queries, beyond which it is released.
+     */
+    static constexpr std::size_t max_retained_parses = 1 << 20;
+    std::vector<node> nodes;
+    std::vector<edge> edges;
+    std::vector<std::uint16_t> values;
+    /**
+     * The root of the trie for every preceding trailing consonant, indexed like @link korean_character::pronunciation_table::leading_consonants @endlink.
+     */
+    std::array<std::uint32_t, 29> roots;
+    /**
+     * The bytes a query may continue with after every trailing consonant, as a bit set, so that parses that cannot continue are dropped at once.
+     */
+    std::array<std::array<std::uint64_t, 4>, 29> next_bytes;
+    /**
+     * The bytes folded into a single boundary between two characters, as a bit set.
+     * The apostrophe is one unless the system uses it in its romanizations.
+     */
+    std::array<std::uint64_t, 4> separators;
+    /**
+     * Finds the nodes of a trie that the query reaches from a node at a position, calling a function with every one that ends a romanization,
+     * its position in the query and the cost of the informal spellings and separators used to reach it.
+     * <code>variants</code> holds the bit set of the spelling variants the query continues with at every position.
+     */
+    template <class Function>
+    void walk(std::string_view query, const std::uint32_t* variants, std::size_t position, std::uint32_t n, unsigned cost, Function& f) const;
+public:
+    /**
+     * @brief A Hangul string a romanization could have been romanized from.
+     */
+    struct candidate {
+        std::string hangul;
+        /**
+         * The cost of the parse, which is lower for more likely strings.
+         */
+        unsigned cost;
+    };
+    /**
+     * The amount of candidates returned by default.
+     */
+    static constexpr std::size_t default_max_candidates = 8;
+    /**
+     * The largest amount of candidates a query keeps and returns. Larger amounts are clamped to it,
+     * since a query keeps that many parses for every position in the romanization.
+     */
+    static constexpr std::size_t max_beam_width = 1024;
+    /**
+     * The longest romanization in bytes a query parses. Longer romanizations have no candidates,
+     * since a query keeps parses for every position in the romanization, and no name or address is nearly as long.
+     */
+    static constexpr std::size_t max_query_size = 256;
+    /**
+     * Builds the tries of the system.
+     */
+    explicit basic_deromanizer();
+    /**
+     * Finds the Hangul strings a romanization could have been romanized from.
+     *
+     * @param latin The romanization, which is expected to consist of Hangul characters alone.
+     * @param max_candidates The maximum amount of candidates to return, at most @link max_beam_width @endlink.
+     * @return The candidates, cheapest first, or none if the romanization cannot be parsed or is longer than @link max_query_size @endlink.
+     */
+    std::vector<candidate> candidates(std::string_view latin, std::size_t max_candidates = default_max_candidates) const;
+    /**
+     * Finds the Hangul strings a romanization could have been romanized from, like @link candidates(std::string_view, std::size_t) const @endlink,
+     * reusing the storage of an existing vector, whose contents are replaced.
+     *
+     * @param latin The romanization, which is expected to consist of Hangul characters alone.
+     * @param max_candidates The maximum amount of candidates to return, at most @link max_beam_width @endlink.
+     * @param result The vector the candidates are written to, cheapest first, which is left empty if the romanization cannot be parsed
+     *               or is longer than @link max_query_size @endlink.
+     */
+    void candidates(std::string_view latin, std::size_t max_candidates, std::vector<candidate>& result) const;
+};
+/**
+ * @brief Finds the Hangul strings a romanization in the Revised Romanization of Korean system could have been romanized from.
+ */
+using korean_deromanizer = basic_deromanizer<revised_romanization>;
+extern template class basic_deromanizer<revised_romanization>;
+extern template class basic_deromanizer<mccune_reischauer>;
+
+/**
+ * @brief Computes 64-bit fingerprints of the plausible romanizations of a Hangul string, such as for indexing names for fuzzy matching.
+ * @details Walks the same tables as @link basic_romanizer @endlink once, giving every piece of the romanization its alternatives:
+ * the unassimilated spelling of a trailing and a leading consonant, such as <code>sinra</code> for 신라,
+ * the pronunciation of ㄹ after ㄴ as ㄴ, such as <code>sinmunno</code> for 신문로,
+ * and the informal spellings listed by the system, such as <code>shin</code> for 신 or <code>kim</code> for 김.
+ * The variants are enumerated from the cheapest, and each one is hashed while it is built, sharing the hash of its prefix with the others,
+ * so that no variant is ever written out.
+ *
+ * Every fingerprint is the @link korean_romanization_hash @endlink of the variant, so a lowercase romanized query matches
+ * the fingerprints of the strings it is a variant of without being fingerprinted itself. The first fingerprint is that of the romanization.
+ * A single instance can be used from many threads at once.
+ *
+ * @tparam System The romanization system.
+ */
+template <class System>
+class basic_romanization_fingerprinter {
+    /**
+     * The informal spellings of every romanization in the tables of the system, as bit sets of indices into <code>System::spelling_variants</code>,
+     * indexed like @link korean_character::pronunciation_table @endlink.
+     */
+    std::array<std::array<std::uint32_t, 19>, 29> leading_consonant_variants;
+    std::array<std::uint32_t, 21> vowel_variants;
+    std::array<std::array<std::uint32_t, 20>, 28> trailing_consonant_variants;
+public:
+    /**
+     * The amount of fingerprints returned by default.
+     */
+    static constexpr std::size_t default_max_fingerprints = 64;
+    /**
+     * The highest total cost of the variants fingerprinted by default, on the scale of @link korean_spelling_variant::cost @endlink,
+     * which allows two informal spellings along with an alternative pronunciation, such as <code>kimchulsu</code> for 김철수.
+     */
+    static constexpr unsigned default_max_cost = 8;
+    /**
+     * Finds the informal spellings of the romanizations of the system.
+     */
+    explicit basic_romanization_fingerprinter();
+    /**
+     * Computes the fingerprints of the plausible romanizations of a Hangul string.
+     *
+     * @param s The Hangul string, in UTF-8.
+     * @param max_fingerprints The maximum amount of fingerprints to return.
+     * @param max_cost The highest total cost of the variants to fingerprint.
+     * @return The distinct fingerprints, cheapest first.
+     * @throws std::range_error If the string is not valid UTF-8.
+     */
+    std::vector<std::uint64_t> fingerprints(std::string_view s, std::size_t max_fingerprints = default_max_fingerprints, unsigned max_cost = default_max_cost) const;
+    /**
+     * Computes the fingerprints of the plausible romanizations of a Hangul string like
+     * @link fingerprints(std::string_view, std::size_t, unsigned) const @endlink, reusing the storage of an existing vector, whose contents are replaced.
+     *
+     * @param s The Hangul string, in UTF-8.
+     * @param max_fingerprints The maximum amount of fingerprints to return.
+     * @param max_cost The highest total cost of the variants to fingerprint.
+     * @param result The vector the distinct fingerprints are written to, cheapest first.
+     * @throws std::range_error If the string is not valid UTF-8.
+     */
+    void fingerprints(std::string_view s, std::size_t max_fingerprints, unsigned max_cost, std::vector<std::uint64_t>& result) const;
+};
+/**
+ * @brief Computes fingerprints of the plausible romanizations of a Hangul string in the Revised Romanization of Korean system.
+ */
+using korean_romanization_fingerprinter = basic_romanization_fingerprinter<revised_romanization>;
+extern template class basic_romanization_fingerprinter<revised_romanization>;
+extern template class basic_romanization_fingerprinter<mccune_reischauer>;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#define KOREAN_ROMANIZER_C_EXPORTS
+#include "korean_romanizer_c.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include "korean_romanizer.h"
+
+namespace {
+/**
+ * Romanizes a string into a buffer, measuring the rest of the romanization once the buffer is full.
+ *
+ * @param s The string to romanize.
+ * @param output The buffer, which may be null if <code>output_capacity</code> is 0.
+ * @param output_capacity The size of the buffer.
+ * @param output_size Receives the size of the romanization.
+ * @return Whether the romanization fit into the buffer.
+ * @throws std::range_error If the string is not valid UTF-8.
+ */
+template <class System>
+bool romanize_into(const std::string_view s, char* const output, const std::size_t output_capacity, std::size_t& output_size) {
+    if (output_capacity >= basic_romanizer<System>::max_romanized_size(s.size())) {
+        output_size = basic_romanizer<System>::romanize(s, output);
+        return true;
+    }
+    // the romanization might not fit, so it is romanized a piece at a time into the buffer of the view
+    bool fits = true;
+    output_size = 0;
+    for (const std::string_view piece : basic_romanized_view<System>(s)) {
+        if (fits && piece.size() <= output_capacity - output_size)
+            std::memcpy(output + output_size, piece.data(), piece.size());
+        else
+            fits = false;
+        output_size += piece.size();
+    }
+    return fits;
+}
+template <class System>
+kr_status romanize_batch(const char* const input, const size_t* const input_offsets, const size_t count, char* const output, const size_t output_capacity, size_t* const output_offsets, size_t* const error_index) {
+    bool fits = true;
+    output_offsets[0] = 0;
+    // stops at a string that failed, leaving the offsets of the rest empty
+    const auto fail = [&](const std::size_t i, const kr_status status) {
+        if (error_index)
+            *error_index = i;
+        std::fill(output_offsets + i + 1, output_offsets + count + 1, output_offsets[i]);
+        return status;
+    };
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t output_size = 0;
+        try {
+            // once a romanization does not fit, the rest are only measured, so that the output stays a prefix of the romanizations
+            char* const out = fits ? output + output_offsets[i] : nullptr;
+            fits = romanize_into<System>({input + input_offsets[i], input_offsets[i + 1] - input_offsets[i]}, out, fits ? output_capacity - output_offsets[i] : 0, output_size) && fits;
+        } catch (const std::range_error&) {
+            return fail(i, KR_INVALID_UTF8);
+        } catch (...) {
+            // nothing may escape to a C caller, such as std::bad_alloc
+            return fail(i, KR_INTERNAL_ERROR);
+        }
+        output_offsets[i + 1] = output_offsets[i] + output_size;
+    }
+    return fits ? KR_OK : KR_BUFFER_TOO_SMALL;
+}
+}
+
+kr_status kr_romanize_into(const kr_system system, const char* const input, const size_t input_size, char* const output, const size_t output_capacity, size_t* const output_size) {
+    if (!output_size || (!input && input_size) || (!output && output_capacity))
+        return KR_INVALID_ARGUMENT;
+    const size_t input_offsets[] = {0, input_size};
+    size_t output_offsets[2];
+    kr_status status = kr_romanize_batch(system, input, input_offsets, 1, output, output_capacity, output_offsets, nullptr);
+    *output_size = output_offsets[1];
+    return status;
+}
+kr_status kr_romanize_batch(const kr_system system, const char* const input, const size_t* const input_offsets, const size_t count, char* const output, const size_t output_capacity, size_t* const output_offsets, size_t* const error_index) {
+    if (!input_offsets || !output_offsets || (!input && input_offsets[count] != input_offsets[0]) || (!output && output_capacity))
+        return KR_INVALID_ARGUMENT;
+    switch (system) {
+    case KR_REVISED_ROMANIZATION:
+        return romanize_batch<revised_romanization>(input, input_offsets, count, output, output_capacity, output_offsets, error_index);
+    case KR_MCCUNE_REISCHAUER:
+        return romanize_batch<mccune_reischauer>(input, input_offsets, count, output, output_capacity, output_offsets, error_index);
+    }
+    return KR_INVALID_ARGUMENT;
+}
+size_t kr_max_romanized_size(const kr_system system, const size_t input_size) {
+    switch (system) {
+    case KR_REVISED_ROMANIZATION:
+        return basic_romanizer<revised_romanization>::max_romanized_size(input_size);
+    case KR_MCCUNE_REISCHAUER:
+        return basic_romanizer<mccune_reischauer>::max_romanized_size(input_size);
+    }
+    return 0;
+}
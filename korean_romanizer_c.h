@@ -0,0 +1,103 @@
+#ifndef korean_romanizer_c_h
+#define korean_romanizer_c_h
+
+#include <stddef.h>
+
+/*
+ * A C interface to korean-romanizer for other languages to call through their foreign function interfaces.
+ * Every function reads caller-owned input, writes to caller-owned output, never allocates and never throws.
+ * The one allocation is in libraries built with KOREAN_ROMANIZER_METRICS: the first call on a thread allocates its counters
+ * once more than 256 threads that have made calls are alive at once.
+ */
+
+#if defined(_WIN32)
+#if defined(KOREAN_ROMANIZER_C_EXPORTS)
+#define KR_API __declspec(dllexport)
+#else
+#define KR_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__)
+#define KR_API __attribute__((visibility("default")))
+#else
+#define KR_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The romanization systems, as in the C++ interface.
+ */
+typedef enum kr_system {
+    KR_REVISED_ROMANIZATION = 0,
+    KR_MCCUNE_REISCHAUER = 1
+} kr_system;
+
+/**
+ * @brief The outcome of a call.
+ */
+typedef enum kr_status {
+    KR_OK = 0,
+    /**
+     * The output did not fit into the buffer. The required size has been reported instead, and the buffer holds a prefix of the output.
+     */
+    KR_BUFFER_TOO_SMALL = 1,
+    /**
+     * The input is not valid UTF-8.
+     */
+    KR_INVALID_UTF8 = 2,
+    /**
+     * The romanization system is unknown, or a pointer that is required is null.
+     */
+    KR_INVALID_ARGUMENT = 3,
+    /**
+     * The library failed unexpectedly, such as by running out of memory. No strings after the one that failed are romanized.
+     */
+    KR_INTERNAL_ERROR = 4
+} kr_status;
+
+/**
+ * Romanizes a Hangul string into a caller-owned buffer.
+ * A buffer of <code>kr_max_romanized_size(system, input_size)</code> bytes always fits the romanization.
+ *
+ * @param system The romanization system.
+ * @param input The UTF-8 string to romanize, which does not need to be NUL-terminated. It may be null if <code>input_size</code> is 0.
+ * @param input_size The size of the string in bytes.
+ * @param output The buffer to write the romanization to, which is not NUL-terminated. It may be null if <code>output_capacity</code> is 0.
+ * @param output_capacity The size of the buffer in bytes.
+ * @param output_size Receives the size of the romanization in bytes, both when it has been written and when it does not fit.
+ * @return <code>KR_OK</code>, <code>KR_BUFFER_TOO_SMALL</code> if the romanization is larger than the buffer, or another status on failure.
+ */
+KR_API kr_status kr_romanize_into(kr_system system, const char* input, size_t input_size, char* output, size_t output_capacity, size_t* output_size);
+
+/**
+ * Romanizes a batch of Hangul strings stored back to back in one buffer, like an Apache Arrow large string column,
+ * into another such buffer in one call. String <code>i</code> is <code>input[input_offsets[i]]</code> up to <code>input[input_offsets[i + 1]]</code>.
+ *
+ * If the romanizations do not fit, the rest of them are only measured,
+ * so that <code>output_offsets</code> holds the offsets the romanizations would have and <code>output_offsets[count]</code> the size they require.
+ *
+ * @param system The romanization system.
+ * @param input The UTF-8 strings to romanize.
+ * @param input_offsets The <code>count + 1</code> offsets of the strings in <code>input</code>, in ascending order.
+ * @param count The amount of strings.
+ * @param output The buffer to write the romanizations to.
+ * @param output_capacity The size of the buffer in bytes.
+ * @param output_offsets Receives the <code>count + 1</code> offsets of the romanizations in <code>output</code>, starting with 0.
+ * @param error_index Receives the index of the first string that is not valid UTF-8 or that failed, if not null.
+ * @return <code>KR_OK</code>, <code>KR_BUFFER_TOO_SMALL</code>, <code>KR_INVALID_UTF8</code> or <code>KR_INTERNAL_ERROR</code>,
+ * in the last two cases of which no strings after the one at <code>error_index</code> are romanized.
+ */
+KR_API kr_status kr_romanize_batch(kr_system system, const char* input, const size_t* input_offsets, size_t count, char* output, size_t output_capacity, size_t* output_offsets, size_t* error_index);
+
+/**
+ * @return The size of a buffer that fits the romanization of any string of the given size, or 0 for an unknown romanization system.
+ */
+KR_API size_t kr_max_romanized_size(kr_system system, size_t input_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,413 @@
+#ifndef reference_romanizer_h
+#define reference_romanizer_h
+
+#include <string>
+
+/**
+ * @brief The switch-based romanization rules the table-driven implementation in korean_romanizer.h was generated from.
+ * @details Kept as a slow, obviously correct reference that the optimized implementation is checked against.
+ * Characters that are not Hangul do not affect the romanization of their neighbors.
+ */
+class reference_romanizer {
+    struct trailing_consonants { enum { ㄱ, ㄲ, ㄳ, ㄴ, ㄵ, ㄶ, ㄷ, ㄹ, ㄺ, ㄻ, ㄼ, ㄽ, ㄾ, ㄿ, ㅀ, ㅁ, ㅂ, ㅄ, ㅅ, ㅆ, ㅇ, ㅈ, ㅊ, ㅋ, ㅌ, ㅍ, ㅎ }; };
+    struct leading_consonants { enum { ㄱ, ㄲ, ㄴ, ㄷ, ㄸ, ㄹ, ㅁ, ㅂ, ㅃ, ㅅ, ㅆ, ㅇ, ㅈ, ㅉ, ㅊ, ㅋ, ㅌ, ㅍ, ㅎ }; };
+    static const std::string leading_consonant_pronunciations[19];
+    static const std::string vowel_pronunciations[21];
+    static const std::string trailing_consonant_pronunciations[27];
+    static std::string leading_consonant_pronunciation(int previous_trailing_consonant_index, int index);
+    static std::string vowel_pronunciation(int index);
+    static std::string trailing_consonant_pronunciation(int next_leading_consonant_index, int index);
+public:
+    /**
+     * Romanizes a sequence of code points.
+     *
+     * @param w The code points to be romanized.
+     * @return The romanization of the code points.
+     */
+    static std::string romanize(const std::u32string& w);
+};
+
+inline const std::string reference_romanizer::leading_consonant_pronunciations[19] = {"g", "kk", "n", "d", "tt", "r", "m", "b", "pp", "s", "ss", "", "j", "jj", "ch", "k", "t", "p", "h"};
+inline std::string reference_romanizer::leading_consonant_pronunciation(const int previous_trailing_consonant_index, const int index) {
+    if (index < 0)
+        return "";
+    switch (index) {
+        // ㄱ
+        case 0:
+            switch (previous_trailing_consonant_index) {
+                case trailing_consonants::ㄺ:
+                case trailing_consonants::ㄻ:
+                case trailing_consonants::ㄼ:
+                case trailing_consonants::ㄽ:
+                case trailing_consonants::ㄾ:
+                case trailing_consonants::ㄿ:
+                case trailing_consonants::ㅀ:
+                case trailing_consonants::ㅎ: return "k";
+                default: return leading_consonant_pronunciations[index];
+            }
+        // ㄴ
+        case 2:
+            switch (previous_trailing_consonant_index) {
+                case trailing_consonants::ㄹ:
+                case trailing_consonants::ㅀ: return "l";
+                default: return leading_consonant_pronunciations[index];
+            }
+        // ㄷ
+        case 3:
+            switch (previous_trailing_consonant_index) {
+                case trailing_consonants::ㄾ:
+                case trailing_consonants::ㄶ:
+                case trailing_consonants::ㅎ: return "t";
+                default: return leading_consonant_pronunciations[index];
+            }
+        // ㄹ
+        case 5:
+            switch (previous_trailing_consonant_index) {
+                case trailing_consonants::ㄱ:
+                case trailing_consonants::ㄲ:
+                case trailing_consonants::ㄳ:
+                case trailing_consonants::ㄺ:
+                case trailing_consonants::ㄼ:
+                case trailing_consonants::ㄿ:
+                case trailing_consonants::ㅁ:
+                case trailing_consonants::ㅂ:
+                case trailing_consonants::ㅄ:
+                case trailing_consonants::ㅇ:
+                case trailing_consonants::ㅋ:
+                case trailing_consonants::ㅍ: return "n";
+                case trailing_consonants::ㄴ:
+                case trailing_consonants::ㄵ:
+                case trailing_consonants::ㄶ:
+                case trailing_consonants::ㄷ:
+                case trailing_consonants::ㄹ:
+                case trailing_consonants::ㄻ:
+                case trailing_consonants::ㄽ:
+                case trailing_consonants::ㄾ:
+                case trailing_consonants::ㅀ:
+                case trailing_consonants::ㅅ:
+                case trailing_consonants::ㅆ:
+                case trailing_consonants::ㅈ:
+                case trailing_consonants::ㅊ:
+                case trailing_consonants::ㅌ:
+                case trailing_consonants::ㅎ: return "l";
+                default: return leading_consonant_pronunciations[index];
+            }
+        // ㅇ
+        case 11:
+            switch (previous_trailing_consonant_index) {
+                case trailing_consonants::ㄱ:
+                case trailing_consonants::ㄺ: return "g";
+                case trailing_consonants::ㄲ: return "kk";
+                case trailing_consonants::ㄳ:
+                case trailing_consonants::ㄽ:
+                case trailing_consonants::ㅄ:
+                case trailing_consonants::ㅅ: return "s";
+                case trailing_consonants::ㄴ:
+                case trailing_consonants::ㄶ: return "n";
+                case trailing_consonants::ㄷ: return "d";
+                case trailing_consonants::ㄵ:
+                case trailing_consonants::ㅈ: return "j";
+                case trailing_consonants::ㄹ: return "r";
+                case trailing_consonants::ㅀ: return "l";
+                case trailing_consonants::ㄻ:
+                case trailing_consonants::ㅁ: return "m";
+                case trailing_consonants::ㄼ:
+                case trailing_consonants::ㅂ: return "b";
+                case trailing_consonants::ㄾ:
+                case trailing_consonants::ㅌ: return "ch";
+                case trailing_consonants::ㅆ: return "ss";
+                case trailing_consonants::ㅊ: return "ch";
+                case trailing_consonants::ㅋ: return "k";
+                case trailing_consonants::ㄿ:
+                case trailing_consonants::ㅍ: return "p";
+                default: return leading_consonant_pronunciations[index];
+            }
+        // ㅈ
+        case 12:
+            switch (previous_trailing_consonant_index) {
+                case trailing_consonants::ㅎ: return "ch";
+                default: return leading_consonant_pronunciations[index];
+            }
+        // ㅉ, ㅊ, ㅋ, ㅌ
+        case 13:
+        case 14:
+        case 15:
+        case 16:
+            switch (previous_trailing_consonant_index) {
+                case trailing_consonants::ㅈ:
+                case trailing_consonants::ㅊ: return "ch";
+                default: return leading_consonant_pronunciations[index];
+            }
+        // ㅎ
+        case 18:
+            switch (previous_trailing_consonant_index) {
+                case trailing_consonants::ㄲ: return "kk";
+                case trailing_consonants::ㄷ:
+                case trailing_consonants::ㄾ:
+                case trailing_consonants::ㅈ:
+                case trailing_consonants::ㅊ:
+                case trailing_consonants::ㅌ: return "ch";
+                case trailing_consonants::ㄺ: return "k";
+                case trailing_consonants::ㅂ:
+                case trailing_consonants::ㄼ: return "p";
+                case trailing_consonants::ㄽ: return "s";
+                case trailing_consonants::ㅀ: return "r";
+                default: return leading_consonant_pronunciations[index];
+            }
+        default: return leading_consonant_pronunciations[index];
+    }
+}
+inline const std::string reference_romanizer::vowel_pronunciations[21] = {"a", "ae", "ya", "yae", "eo", "e", "yeo", "ye", "o", "wa", "wae", "oe", "yo", "u", "wo", "we", "wi", "yu", "eu", "ui", "i"};
+inline std::string reference_romanizer::vowel_pronunciation(const int index) {
+    if (index < 0)
+        return "";
+    return vowel_pronunciations[index];
+}
+inline const std::string reference_romanizer::trailing_consonant_pronunciations[27] = {"k", "k", "k", "n", "n", "n", "d", "l", "k", "m", "l", "l", "l", "l", "l", "m", "p", "p", "t", "t", "ng", "t", "t", "k", "t", "p", "t"};
+inline std::string reference_romanizer::trailing_consonant_pronunciation(const int next_leading_consonant_index, const int index) {
+    if (index < 0)
+        return "";
+    switch (index) {
+        // ㄱ
+        case 0:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄲ:
+                case leading_consonants::ㅇ:
+                case leading_consonants::ㅋ: return "";
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㅁ:
+                case leading_consonants::ㄹ: return "ng";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄲ
+        case 1:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄲ:
+                case leading_consonants::ㅇ:
+                case leading_consonants::ㅋ:
+                case leading_consonants::ㅎ: return "";
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㅁ:
+                case leading_consonants::ㄹ: return "ng";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄳ
+        case 2:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄲ:
+                case leading_consonants::ㅋ: return "";
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㅁ:
+                case leading_consonants::ㄹ: return "ng";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄴ
+        case 3:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄹ: return "l";
+                case leading_consonants::ㅇ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄷ
+        case 6:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㅁ: return "n";
+                case leading_consonants::ㄹ: return "l";
+                case leading_consonants::ㄸ:
+                case leading_consonants::ㅇ:
+                case leading_consonants::ㅌ:
+                case leading_consonants::ㅎ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄹ
+        case 7:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㅇ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄺ
+        case 8:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄱ:
+                case leading_consonants::ㄲ:
+                case leading_consonants::ㅇ:
+                case leading_consonants::ㅎ: return "l";
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㄹ:
+                case leading_consonants::ㅁ: return "ng";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄻ
+        case 9:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄹ:
+                case leading_consonants::ㅁ:
+                case leading_consonants::ㅇ: return "l";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄼ
+        case 10:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㄹ: return "m";
+                case leading_consonants::ㄷ:
+                case leading_consonants::ㄸ:
+                case leading_consonants::ㅂ:
+                case leading_consonants::ㅅ:
+                case leading_consonants::ㅆ:
+                case leading_consonants::ㅈ:
+                case leading_consonants::ㅉ:
+                case leading_consonants::ㅊ:
+                case leading_consonants::ㅋ:
+                case leading_consonants::ㅌ:
+                case leading_consonants::ㅎ: return "p";
+                case leading_consonants::ㅃ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㄿ
+        case 13:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㄹ: return "m";
+                case leading_consonants::ㄷ:
+                case leading_consonants::ㄸ:
+                case leading_consonants::ㅂ:
+                case leading_consonants::ㅅ:
+                case leading_consonants::ㅆ:
+                case leading_consonants::ㅈ:
+                case leading_consonants::ㅉ:
+                case leading_consonants::ㅊ:
+                case leading_consonants::ㅋ:
+                case leading_consonants::ㅌ:
+                case leading_consonants::ㅎ: return "p";
+                case leading_consonants::ㅃ:
+                case leading_consonants::ㅍ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅀ
+        case 14:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㅎ:
+                case leading_consonants::ㅇ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅁ
+        case 15:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㅇ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅂ
+        case 16:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㄹ:
+                case leading_consonants::ㅁ: return "m";
+                case leading_consonants::ㅃ:
+                case leading_consonants::ㅇ:
+                case leading_consonants::ㅎ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅄ
+        case 17:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㄹ:
+                case leading_consonants::ㅁ: return "m";
+                case leading_consonants::ㅃ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅅ, ㅆ, ㅈ, ㅊ
+        case 18:
+        case 19:
+        case 21:
+        case 22:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㅁ: return "n";
+                case leading_consonants::ㄹ: return "l";
+                case leading_consonants::ㄸ:
+                case leading_consonants::ㅇ:
+                case leading_consonants::ㅌ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅋ
+        case 23:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄲ:
+                case leading_consonants::ㅇ: return "";
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㅁ:
+                case leading_consonants::ㄹ: return "ng";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅌ
+        case 24:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㅁ: return "n";
+                case leading_consonants::ㄸ:
+                case leading_consonants::ㅇ:
+                case leading_consonants::ㅎ: return "";
+                case leading_consonants::ㄹ: return "l";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅍ
+        case 25:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㅃ:
+                case leading_consonants::ㅇ: return "";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        // ㅎ
+        case 26:
+            switch (next_leading_consonant_index) {
+                case leading_consonants::ㄱ:
+                case leading_consonants::ㄲ:
+                case leading_consonants::ㄷ:
+                case leading_consonants::ㄸ:
+                case leading_consonants::ㅇ:
+                case leading_consonants::ㅈ:
+                case leading_consonants::ㅉ:
+                case leading_consonants::ㅊ:
+                case leading_consonants::ㅋ:
+                case leading_consonants::ㅌ:
+                case leading_consonants::ㅍ:
+                case leading_consonants::ㅎ: return "";
+                case leading_consonants::ㄴ:
+                case leading_consonants::ㅁ:
+                case leading_consonants::ㄹ: return "n";
+                default: return trailing_consonant_pronunciations[index];
+            }
+        default: return trailing_consonant_pronunciations[index];
+    }
+}
+inline std::string reference_romanizer::romanize(const std::u32string& w) {
+    constexpr char32_t character_min = 0xAC00, character_max = 0xD7A3;
+    const auto is_korean = [&](const std::size_t i) { return i < w.size() && w[i] >= character_min && w[i] <= character_max; };
+    std::string result;
+    for (std::size_t i = 0; i < w.size(); ++i) {
+        if (!is_korean(i)) {
+            const char32_t c = w[i];
+            if (c < 0x80)
+                result += static_cast<char>(c);
+            else if (c < 0x800)
+                result += {static_cast<char>(0xC0 | c >> 6), static_cast<char>(0x80 | (c & 0x3F))};
+            else if (c < 0x10000)
+                result += {static_cast<char>(0xE0 | c >> 12), static_cast<char>(0x80 | (c >> 6 & 0x3F)), static_cast<char>(0x80 | (c & 0x3F))};
+            else
+                result += {static_cast<char>(0xF0 | c >> 18), static_cast<char>(0x80 | (c >> 12 & 0x3F)), static_cast<char>(0x80 | (c >> 6 & 0x3F)), static_cast<char>(0x80 | (c & 0x3F))};
+            continue;
+        }
+        const int s = static_cast<int>(w[i] - character_min);
+        const int previous_trailing_consonant_index = i > 0 && is_korean(i - 1) ? static_cast<int>(w[i - 1] - character_min) % 28 - 1 : -1;
+        const int next_leading_consonant_index = is_korean(i + 1) ? static_cast<int>(w[i + 1] - character_min) / 588 : -1;
+        result += leading_consonant_pronunciation(previous_trailing_consonant_index, s / 588);
+        result += vowel_pronunciation(s % 588 / 28);
+        result += trailing_consonant_pronunciation(next_leading_consonant_index, s % 28 - 1);
+    }
+    return result;
+}
+
+#endif
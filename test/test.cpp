@@ -1,8 +1,879 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <iostream>
+#include <iterator>
+#include <random>
+#if __cplusplus >= 202002L
+#include <ranges>
+#endif
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
 
-#include "korean_romanizer.h";
+#include "korean_romanizer.h"
+#include "korean_romanizer_c.h"
+#include "reference_romanizer.h"
+
+/**
+ * Encodes a sequence of code points as UTF-8.
+ */
+std::string to_utf8(const std::u32string& w) {
+    std::string s;
+    for (const char32_t c : w) {
+        if (c < 0x80)
+            s += static_cast<char>(c);
+        else if (c < 0x800)
+            s += {static_cast<char>(0xC0 | c >> 6), static_cast<char>(0x80 | (c & 0x3F))};
+        else if (c < 0x10000)
+            s += {static_cast<char>(0xE0 | c >> 12), static_cast<char>(0x80 | (c >> 6 & 0x3F)), static_cast<char>(0x80 | (c & 0x3F))};
+        else
+            s += {static_cast<char>(0xF0 | c >> 18), static_cast<char>(0x80 | (c >> 12 & 0x3F)), static_cast<char>(0x80 | (c >> 6 & 0x3F)), static_cast<char>(0x80 | (c & 0x3F))};
+    }
+    return s;
+}
+
+/**
+ * Compares every Hangul character against the reference rules, preceded by every possible trailing consonant
+ * and followed by every possible leading consonant, as well as by nothing and by non-Hangul characters.
+ */
+bool test_every_character_in_every_context() {
+    std::u32string previous_contexts[] = {U"", U"!", U"\U0001F600"};
+    std::u32string next_contexts[] = {U"", U"!", U"\U0001F600"};
+    std::u32string contexts[28 + 3];
+    std::copy(std::begin(previous_contexts), std::end(previous_contexts), contexts);
+    for (char32_t t = 0; t < 28; ++t)
+        contexts[3 + t] = {static_cast<char32_t>(0xAC00 + t)};
+    std::u32string following[19 + 3];
+    std::copy(std::begin(next_contexts), std::end(next_contexts), following);
+    for (char32_t l = 0; l < 19; ++l)
+        following[3 + l] = {static_cast<char32_t>(0xAC00 + l * 588)};
+    for (char32_t c = 0xAC00; c <= 0xD7A3; ++c) {
+        for (const std::u32string& previous : contexts) {
+            for (const std::u32string& next : following) {
+                const std::u32string w = previous + c + next;
+                const std::string expected = reference_romanizer::romanize(w);
+                if (const std::string actual = korean_romanizer::romanize(to_utf8(w)); actual != expected) {
+                    std::cerr << to_utf8(w) << ": expected \"" << expected << "\", got \"" << actual << "\"\n";
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks that the overloads writing to caller-owned storage produce the same romanization as the one returning a string.
+ */
+bool test_caller_owned_output() {
+    const std::string s = "서울특별시 종로구 세종대로 209, 신문로 (Seoul)";
+    const std::string expected = korean_romanizer::romanize(s);
+    std::string appended = "> ";
+    korean_romanizer::romanize(s, appended);
+    std::string buffer(korean_romanizer::max_romanized_size(s.size()), '\0');
+    buffer.resize(korean_romanizer::romanize(s, buffer.data()));
+    if (appended != "> " + expected || buffer != expected) {
+        std::cerr << "expected \"" << expected << "\", got \"" << appended << "\" and \"" << buffer << "\"\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Checks that malformed UTF-8 is rejected rather than passed through.
+ */
+bool test_invalid_utf8() {
+    for (const char* s : {"\x80", "\xC0\x80", "\xE0\x80\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xEA\xB0", "\xEA\xB0가"}) {
+        try {
+            korean_romanizer::romanize(s);
+            std::cerr << "expected std::range_error for \"" << s << "\"\n";
+            return false;
+        } catch (const std::range_error&) {
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks that every error policy handles each maximal invalid subsequence as a single error and reports where the first one is.
+ */
+bool test_error_policies() {
+    struct test_case {
+        std::string_view s;
+        std::size_t error_count;
+        std::size_t first_error_offset;
+        std::string_view replaced;
+    };
+    const test_case cases[] = {
+        {"학교\x80가", 1, 6, "hakgyo\uFFFDga"},
+        {"\xE0\x80\x80", 3, 0, "\uFFFD\uFFFD\uFFFD"},
+        {"\xED\xA0\x80한", 3, 0, "\uFFFD\uFFFD\uFFFDhan"},
+        {"a\xF0\x9F\x98" "a", 1, 1, "a\uFFFDa"},
+        {"서울\xEA\xB0", 1, 6, "seoul\uFFFD"},
+        {"\xC0\xAF\xFF", 3, 0, "\uFFFD\uFFFD\uFFFD"},
+        {"신문로 \U0001F600", 0, std::string_view::npos, "sinmullo \U0001F600"},
+    };
+    for (const test_case& c : cases) {
+        std::string replaced = "> ";
+        std::string passed_through;
+        std::string skipped;
+        const korean_romanizer_result result = korean_romanizer::romanize(c.s, replaced, korean_romanizer_error_policy::replace);
+        korean_romanizer::romanize(c.s, passed_through, korean_romanizer_error_policy::pass_through);
+        korean_romanizer::romanize(c.s, skipped, korean_romanizer_error_policy::skip);
+        std::string expected_skipped(c.replaced);
+        for (std::size_t i; (i = expected_skipped.find("\uFFFD")) != std::string::npos;)
+            expected_skipped.erase(i, 3);
+        if (result.error_count != c.error_count || result.first_error_offset != c.first_error_offset || static_cast<bool>(result) != !c.error_count
+            || replaced != "> " + std::string(c.replaced) || skipped != expected_skipped) {
+            std::cerr << c.s << ": got " << result.error_count << " errors from " << result.first_error_offset << " and \"" << replaced << "\", \"" << skipped << "\"\n";
+            return false;
+        }
+        // the bytes passed through are the errors again, which skipping drops
+        std::string reskipped;
+        korean_romanizer::romanize(passed_through, reskipped, korean_romanizer_error_policy::skip);
+        if (reskipped != skipped || (!c.error_count && passed_through != skipped)) {
+            std::cerr << c.s << ": passing errors through lost bytes\n";
+            return false;
+        }
+    }
+    try {
+        std::string result;
+        korean_romanizer::romanize("\x80", result, korean_romanizer_error_policy::throw_exception);
+        std::cerr << "expected std::range_error with the throwing error policy\n";
+        return false;
+    } catch (const std::range_error&) {
+    }
+    return true;
+}
+
+/**
+ * Compares strings with ASCII runs of every length around the sizes the ASCII scan works with against the reference rules.
+ */
+bool test_ascii_runs() {
+    for (std::size_t length = 0; length <= 70; ++length) {
+        const std::u32string run(length, U'a');
+        const std::u32string w = U"한국" + run + U"어" + run + U"é읽" + run;
+        const std::string expected = reference_romanizer::romanize(w);
+        if (const std::string actual = korean_romanizer::romanize(to_utf8(w)); actual != expected) {
+            std::cerr << to_utf8(w) << ": expected \"" << expected << "\", got \"" << actual << "\"\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Compares long runs of random Hangul characters, interrupted by characters just outside the Hangul Syllables block,
+ * against the reference rules so that every block and vector boundary of the decoder is crossed.
+ */
+bool test_hangul_runs() {
+    std::mt19937 random(20240101);
+    const char32_t interruptions[] = {U'a', U'\u00E9', U'\u3131', U'\uABFF', U'\uD7A4', U'\U0001F600'};
+    for (std::size_t length = 1; length <= 300; ++length) {
+        std::u32string w;
+        for (std::size_t i = 0; i < length; ++i)
+            w += static_cast<char32_t>(0xAC00 + random() % 11172);
+        for (std::size_t i = 0; i < length % 2 * length / 20; ++i)
+            w[random() % length] = interruptions[random() % std::size(interruptions)];
+        const std::string expected = reference_romanizer::romanize(w);
+        if (const std::string actual = korean_romanizer::romanize(to_utf8(w)); actual != expected) {
+            std::cerr << to_utf8(w) << ": expected \"" << expected << "\", got \"" << actual << "\"\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks that feeding a string to a stream in chunks of every size produces the same romanization as romanizing it at once,
+ * and that a string ending in the middle of a UTF-8 sequence is rejected without affecting the next string.
+ */
+bool test_stream() {
+    const std::string s = "신문로에서 밥을 먹었어요. 같이 갈래? \U0001F600 좋아요!! 안녕하세요";
+    const std::string expected = korean_romanizer::romanize(s);
+    korean_romanizer_stream stream;
+    for (std::size_t chunk_size = 1; chunk_size <= s.size(); ++chunk_size) {
+        std::string actual;
+        for (std::size_t i = 0; i < s.size(); i += chunk_size)
+            stream.feed(std::string_view(s).substr(i, chunk_size), actual);
+        stream.finish(actual);
+        if (actual != expected) {
+            std::cerr << "chunks of " << chunk_size << ": expected \"" << expected << "\", got \"" << actual << "\"\n";
+            return false;
+        }
+    }
+    std::string actual;
+    stream.feed("신문\xEB\x85", actual);
+    try {
+        stream.finish(actual);
+        std::cerr << "expected std::range_error for a truncated stream\n";
+        return false;
+    } catch (const std::range_error&) {
+    }
+    actual.clear();
+    stream.feed("라", actual);
+    stream.finish(actual);
+    if (actual != "ra") {
+        std::cerr << "a stream reused after a truncated string: expected \"ra\", got \"" << actual << "\"\n";
+        return false;
+    }
+    return true;
+}
+
+#ifdef __cpp_lib_ranges
+static_assert(std::ranges::input_range<korean_romanized_view>);
+#endif
+
+/**
+ * Checks that the pieces of romanized views of random strings, including decomposed Hangul characters cut anywhere by the chunks of the view,
+ * make up their romanizations, and that their sizes, hashes and comparisons match those of the romanizations.
+ */
+bool test_romanized_view() {
+    const std::u32string pieces[] = {U"가", U"닭", U"읽", U"이", U"\u1112\u1161\u11AB", U"\u1100\u116E", U"\u11A8", U"\u1100", U"a", U" ", U"é", U"\U0001F600"};
+    std::mt19937 random(20240109);
+    for (int i = 0; i < 2000; ++i) {
+        std::u32string w;
+        for (std::size_t length = random() % 200; w.size() < length;)
+            w += pieces[random() % std::size(pieces)];
+        const std::string s = to_utf8(w), expected = korean_romanizer::romanize(s);
+        const korean_romanized_view view(s);
+        std::string actual;
+        for (const std::string_view piece : view)
+            actual += piece;
+        if (actual != expected || view.size() != expected.size() || view.hash() != korean_romanization_hash(expected)) {
+            std::cerr << s << ": expected \"" << expected << "\", got \"" << actual << "\"\n";
+            return false;
+        }
+        std::string smaller = expected, larger = expected;
+        if (!expected.empty())
+            --smaller[random() % smaller.size()];
+        larger.insert(random() % (larger.size() + 1), 1, '\xFF');
+        if (view.compare(expected) != 0 || (!expected.empty() && view.compare(smaller) <= 0) || view.compare(larger) >= 0
+            || (!expected.empty() && view.compare(std::string_view(expected).substr(0, expected.size() - 1)) <= 0) || view.compare(expected + "a") >= 0) {
+            std::cerr << s << ": the romanized view compares differently from \"" << expected << "\"\n";
+            return false;
+        }
+    }
+    if (basic_romanized_view<mccune_reischauer>("한국어").compare("han'gugŏ") != 0 || korean_romanized_view().size() || korean_romanized_view("").begin() != korean_romanized_view("").end()) {
+        std::cerr << "unexpected romanized view of a McCune-Reischauer or empty string\n";
+        return false;
+    }
+    try {
+        korean_romanized_view("안녕\xEB\x85").size();
+        std::cerr << "expected std::range_error for a romanized view of invalid UTF-8\n";
+        return false;
+    } catch (const std::range_error&) {
+    }
+    return true;
+}
+
+/**
+ * Checks that romanizing a large string on multiple threads produces the same romanization as romanizing it on one,
+ * wherever the chunk boundaries fall.
+ */
+bool test_parallel() {
+    std::mt19937 random(20240102);
+    const char32_t others[] = {U' ', U'a', U'\u00E9', U'\U0001F600'};
+    for (const unsigned thread_count : {2u, 3u, 7u}) {
+        std::u32string w;
+        while (w.size() < korean_romanizer::min_parallel_chunk_size * 3)
+            w += random() % 8 ? static_cast<char32_t>(0xAC00 + random() % 11172) : others[random() % std::size(others)];
+        const std::string s = to_utf8(w);
+        const std::string expected = korean_romanizer::romanize(s);
+        if (korean_romanizer::romanize_parallel(s, thread_count) != expected) {
+            std::cerr << "romanizing on " << thread_count << " threads differs from romanizing on one\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks that romanizing a batch of strings, on one thread and on multiple threads,
+ * produces the same romanizations as romanizing every string on its own.
+ */
+bool test_batch() {
+    std::mt19937 random(20240103);
+    std::vector<std::string> strings;
+    for (std::size_t size = 0; size < korean_romanizer::min_parallel_chunk_size * 3; size += strings.back().size()) {
+        std::u32string w;
+        for (std::size_t length = random() % 12; w.size() < length;)
+            w += random() % 6 ? static_cast<char32_t>(0xAC00 + random() % 11172) : U' ';
+        strings.push_back(to_utf8(w));
+    }
+    const std::vector<std::string_view> views(strings.begin(), strings.end());
+    korean_romanizer_batch batch;
+    for (const unsigned thread_count : {1u, 4u}) {
+        batch.romanize(views.data(), views.size(), thread_count);
+        if (batch.size() != strings.size() || batch.offsets().back() != static_cast<std::int64_t>(batch.data().size())) {
+            std::cerr << "the batch romanized on " << thread_count << " threads has the wrong size\n";
+            return false;
+        }
+        for (std::size_t i = 0; i < strings.size(); ++i) {
+            if (batch[i] != korean_romanizer::romanize(strings[i])) {
+                std::cerr << strings[i] << ": expected \"" << korean_romanizer::romanize(strings[i]) << "\", got \"" << batch[i] << "\"\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks that romanizing through a cache small enough to evict words, on multiple threads at once,
+ * produces the same romanizations as romanizing without it, and that every word is counted as a hit or a miss.
+ */
+bool test_cache() {
+    std::mt19937 random(20240104);
+    std::vector<std::u32string> words(500);
+    for (std::u32string& word : words)
+        for (std::size_t length = 1 + random() % 5; word.size() < length;)
+            word += static_cast<char32_t>(0xAC00 + random() % 11172);
+    const char32_t delimiters[] = {U' ', U',', U'\u00E9', U'\U0001F600'};
+    std::vector<std::string> strings(200);
+    std::size_t word_count = 0;
+    for (std::string& s : strings) {
+        std::u32string w;
+        for (std::size_t i = random() % 20; i; --i, ++word_count)
+            w += words[random() % words.size()] + delimiters[random() % std::size(delimiters)];
+        s = to_utf8(w);
+    }
+    korean_romanizer_cache cache(128, 4);
+    std::atomic<bool> passed = true;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (const std::string& s : strings)
+                if (cache.romanize(s) != korean_romanizer::romanize(s))
+                    passed = false;
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    if (!passed || cache.hits() + cache.misses() != word_count * 4 || !cache.hits() || cache.size() > 128) {
+        std::cerr << "the cache romanized differently or miscounted " << cache.hits() << " hits and " << cache.misses() << " misses\n";
+        return false;
+    }
+    std::string appended = "> ";
+    try {
+        cache.romanize("서울 \xEA\xB0", appended);
+        std::cerr << "expected std::range_error from the cache\n";
+        return false;
+    } catch (const std::range_error&) {
+    }
+    return appended == "> ";
+}
+
+/**
+ * Checks that the offset map recorded alongside a romanization maps every character to its part of the romanization and back,
+ * that untouched characters map to themselves, and that Hangul characters between untouched ones map to their romanization on their own.
+ */
+bool test_offset_map() {
+    std::mt19937 random(20240105);
+    const char32_t others[] = {U' ', U'a', U'\u00E9', U'\U0001F600'};
+    std::u32string w;
+    for (std::size_t i = 0; i < 1000; ++i)
+        w += random() % 3 ? static_cast<char32_t>(0xAC00 + random() % 11172) : others[random() % std::size(others)];
+    w += std::u32string(200, U'한') + U"국";
+    const std::string s = to_utf8(w);
+    std::string romanization = "> ";
+    korean_romanizer_offset_map offsets;
+    korean_romanizer::romanize(s, romanization, offsets);
+    romanization.erase(0, 2);
+    if (romanization != korean_romanizer::romanize(s) || offsets.source_length() != s.size() || offsets.romanization_length() != romanization.size()) {
+        std::cerr << "the romanization recorded with offsets differs from the romanization without them\n";
+        return false;
+    }
+    std::size_t source_offset = 0;
+    for (std::size_t i = 0; i < w.size(); ++i) {
+        const std::size_t length = to_utf8(w.substr(i, 1)).size();
+        const std::size_t begin = offsets.to_romanization(source_offset);
+        const std::size_t end = offsets.to_romanization(source_offset + length);
+        const std::string_view part = std::string_view(romanization).substr(begin, end - begin);
+        const bool is_hangul = w[i] >= 0xAC00 && w[i] <= 0xD7A3;
+        const bool is_isolated = is_hangul && (!i || !(w[i - 1] >= 0xAC00 && w[i - 1] <= 0xD7A3)) && (i + 1 == w.size() || !(w[i + 1] >= 0xAC00 && w[i + 1] <= 0xD7A3));
+        if (begin >= end || (!is_hangul && part != s.substr(source_offset, length)) || (is_isolated && part != korean_romanizer::romanize(to_utf8(w.substr(i, 1))))) {
+            std::cerr << "character " << i << " maps to the wrong part \"" << part << "\" of the romanization\n";
+            return false;
+        }
+        for (std::size_t j = begin; j < end; ++j) {
+            if (offsets.to_source(j) != (is_hangul ? source_offset : source_offset + (j - begin))) {
+                std::cerr << "byte " << j << " of the romanization maps back to " << offsets.to_source(j) << " instead of character " << i << '\n';
+                return false;
+            }
+        }
+        source_offset += length;
+    }
+    return offsets.to_romanization(s.size()) == romanization.size() && offsets.to_source(romanization.size()) == s.size();
+}
+
+/**
+ * Decomposes every Hangul character of a string into conjoining jamo as in NFD, or only splits off its trailing consonant.
+ */
+std::u32string decompose(const std::u32string& w, const bool only_trailing_consonants) {
+    std::u32string decomposed;
+    for (const char32_t c : w) {
+        if (c < 0xAC00 || c > 0xD7A3) {
+            decomposed += c;
+            continue;
+        }
+        const char32_t index = c - 0xAC00;
+        if (only_trailing_consonants)
+            decomposed += c - index % 28;
+        else
+            decomposed += {static_cast<char32_t>(0x1100 + index / 588), static_cast<char32_t>(0x1161 + index / 28 % 21)};
+        if (index % 28)
+            decomposed += static_cast<char32_t>(0x11A7 + index % 28);
+    }
+    return decomposed;
+}
+
+/**
+ * Checks that decomposed (NFD) strings are romanized like their composed (NFC) forms in every way of romanizing them,
+ * and that jamo which do not spell a Hangul character are left untouched.
+ */
+bool test_decomposed_jamo() {
+    std::mt19937 random(20240107);
+    const char32_t others[] = {U' ', U'a', U'\u00E9', U'\U0001F600', U'\u1100', U'\u11A8', U'\u3131'};
+    std::u32string w;
+    while (w.size() < korean_romanizer::min_parallel_chunk_size)
+        w += random() % 4 ? static_cast<char32_t>(0xAC00 + random() % 11172) : others[random() % std::size(others)];
+    const std::string expected = korean_romanizer::romanize(to_utf8(w));
+    for (const bool only_trailing_consonants : {false, true}) {
+        const std::string s = to_utf8(decompose(w, only_trailing_consonants));
+        std::string with_offsets;
+        korean_romanizer_offset_map offsets;
+        korean_romanizer::romanize(s, with_offsets, offsets);
+        std::string replaced;
+        korean_romanizer::romanize(s, replaced, korean_romanizer_error_policy::replace);
+        korean_romanizer_cache cache;
+        if (korean_romanizer::romanize(s) != expected || korean_romanizer::romanize_parallel(s, 7) != expected || with_offsets != expected || replaced != expected
+            || cache.romanize(s) != expected || basic_romanizer<mccune_reischauer>::romanize(s) != basic_romanizer<mccune_reischauer>::romanize(to_utf8(w))) {
+            std::cerr << "a decomposed string is romanized differently from its composed form\n";
+            return false;
+        }
+        if (offsets.source_length() != s.size() || offsets.romanization_length() != expected.size()) {
+            std::cerr << "the offsets of a decomposed string do not cover it\n";
+            return false;
+        }
+    }
+    // the later jamo of a Hangul character map to the end of its romanization, and its romanization back to its first jamo
+    std::string romanization;
+    korean_romanizer_offset_map offsets;
+    korean_romanizer::romanize("\u1112\u1161\u11AB가", romanization, offsets);
+    if (romanization != "hanga" || offsets.to_romanization(0) != 0 || offsets.to_romanization(6) != 3 || offsets.to_romanization(9) != 3 || offsets.to_source(2) != 0 || offsets.to_source(3) != 9) {
+        std::cerr << "the offsets of a decomposed string map to the wrong places\n";
+        return false;
+    }
+    const std::pair<std::string_view, std::string_view> strings[] = {
+        {"\u1112\u1161\u11AB\u1100\u116E\u11A8\u110B\u1165", "hangugeo"}, {"\u1109\u1165\u110B\u116E\u11AF", "seoul"},
+        {"\u1100", "\u1100"}, {"\u1161가", "\u1161ga"}, {"\u11A8", "\u11A8"}, {"각\u11A8", "gak\u11A8"}, {"\u1100\u1100\u1161\u11A8", "\u1100gak"},
+        {"가\u11A8\u1100\u1161 \u1100", "gakga \u1100"}, {"ㅎㅏㄴ", "ㅎㅏㄴ"},
+    };
+    for (const auto& [s, romanization] : strings) {
+        if (const std::string actual = korean_romanizer::romanize(s); actual != romanization) {
+            std::cerr << s << ": expected \"" << romanization << "\", got \"" << actual << "\"\n";
+            return false;
+        }
+        korean_romanizer_stream stream;
+        for (std::size_t chunk_size = 1; chunk_size <= s.size(); ++chunk_size) {
+            std::string actual;
+            for (std::size_t i = 0; i < s.size(); i += chunk_size)
+                stream.feed(s.substr(i, chunk_size), actual);
+            stream.finish(actual);
+            if (actual != romanization) {
+                std::cerr << s << " in chunks of " << chunk_size << ": expected \"" << romanization << "\", got \"" << actual << "\"\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks that the longest word of a dictionary overrides the pronunciation rules wherever a word starts, that a dictionary
+ * of words romanized by the rules themselves changes nothing, and that a dictionary survives being saved and loaded.
+ */
+bool test_dictionary() {
+    const korean_romanizer_dictionary dictionary = korean_romanizer_dictionary::parse(
+        "# proper nouns\n"
+        "신문로\tsinmullo\n"
+        "신문로\tsinmunno\n"
+        "서울\tSeoul\r\n"
+        "\n"
+        "서울역   Seoul Station  \n");
+    const std::pair<std::string_view, std::string_view> expected[] = {
+        {"신문로에서 난로", "sinmunnoeseo nallo"},
+        {"신문로신문로", "sinmunnosinmunno"},
+        {"서울역서울", "Seoul StationSeoul"},
+        {"서울역앞, 서울에", "Seoul Stationap, Seoule"},
+        {"(서울)", "(Seoul)"},
+        {"동서울", "dongseoul"},
+        {"서", "seo"},
+        {"난로 서울, 신문로 난로", "nallo Seoul, sinmunno nallo"},
+        // a word at the start of a run longer than the romanizer decodes at once
+        {"서울역가나다라마바사아자차카타파하가나다라마바사아자차카타파하가나다라마바사아자차카타파하가나다라마바사아자차카타파하가나다라마바사아자차카타파하", "Seoul Stationganadaramabasaajachakatapahaganadaramabasaajachakatapahaganadaramabasaajachakatapahaganadaramabasaajachakatapahaganadaramabasaajachakatapaha"},
+    };
+    for (const auto& [s, romanization] : expected) {
+        if (const std::string actual = korean_romanizer::romanize(s, dictionary); actual != romanization) {
+            std::cerr << s << ": expected \"" << romanization << "\", got \"" << actual << "\"\n";
+            return false;
+        }
+    }
+    if (dictionary.size() != 3)
+        return false;
+    // runs shorter than the shortest word are not looked up, and an empty dictionary looks up none
+    const korean_romanizer_dictionary long_words = korean_romanizer_dictionary::parse("서울역 Seoul Station\n");
+    if (korean_romanizer::romanize("서울 서울역 서", long_words) != "seoul Seoul Station seo"
+        || korean_romanizer::romanize("서울 서울역", korean_romanizer_dictionary()) != "seoul seouryeok") {
+        std::cerr << "a run shorter than the shortest word of a dictionary is romanized wrongly\n";
+        return false;
+    }
+    for (const std::string_view text : {"서울\n", "abc def\n", "서울 \n", "\xEA\xB0\n"}) {
+        try {
+            korean_romanizer_dictionary::parse(text);
+            std::cerr << "expected std::invalid_argument for a malformed dictionary\n";
+            return false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+
+    // words ending without a trailing consonant are romanized the same as the start of a word after them
+    std::mt19937 random(20240107);
+    std::vector<std::string> words(20000), romanizations(words.size());
+    std::vector<std::pair<std::string_view, std::string_view>> pairs(words.size());
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        std::u32string w;
+        for (std::size_t length = random() % 3; w.size() < length;)
+            w += static_cast<char32_t>(0xAC00 + random() % 11172);
+        w += static_cast<char32_t>(0xAC00 + random() % 399 * 28);
+        words[i] = to_utf8(w);
+        romanizations[i] = korean_romanizer::romanize(words[i]);
+        pairs[i] = {words[i], romanizations[i]};
+    }
+    std::string s;
+    for (std::size_t i = 0; i < 5000; ++i)
+        s += random() % 2 ? words[random() % words.size()] + to_utf8(std::u32string(1, static_cast<char32_t>(0xAC00 + random() % 11172))) + " " : words[random() % words.size()] + "! ";
+    const korean_romanizer_dictionary rules(pairs.data(), pairs.size());
+    // and so are words back to back in runs of Hangul characters much longer than the romanizer decodes at once
+    std::string run;
+    for (std::size_t i = 0; i < 2000; ++i)
+        run += words[random() % words.size()];
+    for (const std::string& text : {s, run, run + "?" + run}) {
+        if (korean_romanizer::romanize(text, rules) != korean_romanizer::romanize(text)) {
+            std::cerr << "a dictionary of words romanized by the pronunciation rules changes the romanization\n";
+            return false;
+        }
+    }
+
+    const std::string path = "korean_romanizer_dictionary_test.bin";
+    dictionary.save(path);
+    const korean_romanizer_dictionary loaded = korean_romanizer_dictionary::load(path);
+    std::remove(path.c_str());
+    if (loaded.size() != dictionary.size() || korean_romanizer::romanize("신문로 서울역", loaded) != "sinmunno Seoul Station") {
+        std::cerr << "the loaded dictionary differs from the saved one\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Checks the McCune-Reischauer romanizations of words exercising its voicing, aspiration, liaison and nasalization rules,
+ * and that the stream and batch romanizers and parallel romanization follow the romanization system they are instantiated with.
+ */
+bool test_mccune_reischauer() {
+    using romanizer = basic_romanizer<mccune_reischauer>;
+    const std::pair<std::string_view, std::string_view> words[] = {
+        {"서울", "sŏul"}, {"부산", "pusan"}, {"대구", "taegu"}, {"인천", "inch'ŏn"}, {"광주", "kwangju"},
+        {"대전", "taejŏn"}, {"한국", "han'guk"}, {"조선", "chosŏn"}, {"종로", "chongno"}, {"신라", "silla"},
+        {"독립문", "tongnimmun"}, {"김치", "kimch'i"}, {"한글", "han'gŭl"}, {"평양", "p'yŏngyang"}, {"제주", "cheju"},
+        {"청주", "ch'ŏngju"}, {"경복궁", "kyŏngbokkung"}, {"백두산", "paektusan"}, {"같이", "kach'i"}, {"좋아", "choa"},
+        {"많이", "mani"}, {"학교", "hakkyo"}, {"국민", "kungmin"}, {"십리", "simni"}, {"강릉", "kangnŭng"},
+        {"낙동강", "naktonggang"}, {"불국사", "pulguksa"}, {"압록강", "amnokkang"}, {"합니다", "hamnida"}, {"잡지", "chapchi"},
+        {"부엌", "puŏk"}, {"서울시", "sŏulsi"}, {"안녕하세요!", "annyŏnghaseyo!"}, {"한국어 \U0001F600", "han'gugŏ \U0001F600"},
+    };
+    for (const auto& [word, expected] : words) {
+        if (const std::string actual = romanizer::romanize(word); actual != expected) {
+            std::cerr << word << ": expected \"" << expected << "\", got \"" << actual << "\"\n";
+            return false;
+        }
+    }
+    std::mt19937 random(20240106);
+    std::u32string w;
+    while (w.size() < romanizer::min_parallel_chunk_size * 3)
+        w += random() % 6 ? static_cast<char32_t>(0xAC00 + random() % 11172) : U' ';
+    const std::string s = to_utf8(w);
+    const std::string expected = romanizer::romanize(s);
+    if (expected == korean_romanizer::romanize(s) || romanizer::romanize_parallel(s, 3) != expected) {
+        std::cerr << "romanizing on 3 threads differs from romanizing on one with McCune-Reischauer\n";
+        return false;
+    }
+    basic_romanizer_stream<mccune_reischauer> stream;
+    std::string streamed;
+    for (std::size_t i = 0; i < s.size(); i += 1000)
+        stream.feed(std::string_view(s).substr(i, 1000), streamed);
+    stream.finish(streamed);
+    if (streamed != expected) {
+        std::cerr << "streaming differs from romanizing at once with McCune-Reischauer\n";
+        return false;
+    }
+    std::vector<std::string_view> views;
+    for (std::size_t i = 0; i < s.size(); i = s.find(' ', i) + 1) {
+        views.push_back(std::string_view(s).substr(i, s.find(' ', i) - i));
+        if (s.find(' ', i) == std::string::npos)
+            break;
+    }
+    basic_romanizer_batch<mccune_reischauer> batch;
+    batch.romanize(views.data(), views.size(), 2);
+    for (std::size_t i = 0; i < views.size(); ++i) {
+        if (batch[i] != romanizer::romanize(views[i])) {
+            std::cerr << views[i] << ": expected \"" << romanizer::romanize(views[i]) << "\", got \"" << batch[i] << "\"\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks the cheapest candidates for romanized queries, including informal spellings and separators,
+ * and that random words are found among the candidates for their romanizations.
+ */
+bool test_deromanizer() {
+    const korean_deromanizer deromanizer;
+    const basic_deromanizer<mccune_reischauer> mccune_reischauer_deromanizer;
+    const std::pair<std::string_view, std::string_view> queries[] = {
+        {"sinchon", "신촌"}, {"Sin-chon", "신촌"}, {"sin chon", "신촌"}, {"shinchon", "신촌"}, {"seoul", "서울"}, {"hanguk", "한국"},
+        {"hang-uk", "항욱"}, {"jung-ang", "중앙"}, {"annyeonghaseyo", "안녕하세요"}, {"Gyeongbokgung", "경복궁"}, {"Daegu", "대구"},
+    };
+    for (const auto& [query, expected] : queries) {
+        const auto candidates = deromanizer.candidates(query);
+        if (candidates.empty() || candidates.front().hangul != expected) {
+            std::cerr << query << ": expected \"" << expected << "\" first, got \"" << (candidates.empty() ? "" : candidates.front().hangul) << "\"\n";
+            return false;
+        }
+    }
+    for (const auto& [query, expected] : {std::pair<std::string_view, std::string_view>{"han'guk", "한국"}, {"sŏul", "서울"}, {"SŎUL", "서울"}, {"Pusan", "부산"}}) {
+        const auto candidates = mccune_reischauer_deromanizer.candidates(query);
+        if (candidates.empty() || candidates.front().hangul != expected) {
+            std::cerr << query << ": expected \"" << expected << "\" first with McCune-Reischauer, got \"" << (candidates.empty() ? "" : candidates.front().hangul) << "\"\n";
+            return false;
+        }
+    }
+    if (!deromanizer.candidates("").empty() || !deromanizer.candidates(" - ").empty() || !deromanizer.candidates("xyz").empty()
+        || !deromanizer.candidates("sinchon", 0).empty() || deromanizer.candidates("sinchon", 3).size() != 3) {
+        std::cerr << "unexpected candidates for an empty, unparsable or bounded query\n";
+        return false;
+    }
+
+    // words of rare jamo can have hundreds of cheaper parses, so the bound is high enough to keep every parse of two characters
+    std::mt19937 random(20240108);
+    std::vector<korean_deromanizer::candidate> candidates;
+    for (int i = 0; i < 1000; ++i) {
+        std::u32string w;
+        for (std::size_t length = 1 + random() % 2; w.size() < length;)
+            w += static_cast<char32_t>(0xAC00 + random() % 11172);
+        const std::string word = to_utf8(w), romanization = korean_romanizer::romanize(word);
+        deromanizer.candidates(romanization, 1024, candidates);
+        if (std::none_of(candidates.begin(), candidates.end(), [&word](const auto& c) { return c.hangul == word; })) {
+            std::cerr << word << " is not a candidate for \"" << romanization << "\"\n";
+            return false;
+        }
+        for (std::size_t j = 1; j < candidates.size(); ++j) {
+            if (candidates[j].cost < candidates[j - 1].cost) {
+                std::cerr << "the candidates for \"" << romanization << "\" are not ordered by cost\n";
+                return false;
+            }
+        }
+    }
+    // a larger amount than the beam can hold is clamped rather than allocated
+    deromanizer.candidates("sinchon", SIZE_MAX, candidates);
+    const std::vector<korean_deromanizer::candidate> widest = deromanizer.candidates("sinchon", korean_deromanizer::max_beam_width);
+    if (candidates.size() != widest.size() || candidates.size() > korean_deromanizer::max_beam_width || candidates.empty() || candidates[0].hangul != "신촌") {
+        std::cerr << "the amount of candidates is not clamped to the beam width\n";
+        return false;
+    }
+    // a romanization longer than max_query_size has no candidates rather than a lattice for every byte
+    std::string query;
+    while (query.size() + 7 <= korean_deromanizer::max_query_size)
+        query += "sinchon";
+    if (deromanizer.candidates(query, 1).empty() || !deromanizer.candidates(query + std::string(korean_deromanizer::max_query_size, 'a'), 1).empty()) {
+        std::cerr << "romanizations longer than the maximum query size are not rejected\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Checks that the fingerprints of Hangul strings include those of their romanizations first and of their likely variants,
+ * including for strings of random characters, jamo and text that is not Hangul.
+ */
+bool test_fingerprints() {
+    const korean_romanization_fingerprinter fingerprinter;
+    const std::pair<std::string_view, std::string_view> variants[] = {
+        {"난로", "nanno"}, {"신문로", "sinmunno"}, {"신라", "sinra"}, {"신촌", "shinchon"}, {"김철수", "kimchulsu"}, {"이수진", "eesujin"}, {"한국어 abc", "hanguko abc"},
+    };
+    for (const auto& [s, variant] : variants) {
+        const std::vector<std::uint64_t> fingerprints = fingerprinter.fingerprints(s);
+        if (std::find(fingerprints.begin(), fingerprints.end(), korean_romanization_hash(variant)) == fingerprints.end()) {
+            std::cerr << s << ": expected a fingerprint of \"" << variant << "\"\n";
+            return false;
+        }
+    }
+    if (basic_romanization_fingerprinter<mccune_reischauer>().fingerprints("한국어")[0] != korean_romanization_hash("han'gugŏ")
+        || fingerprinter.fingerprints("").size() != 1 || fingerprinter.fingerprints("김철수", 0).size() || fingerprinter.fingerprints("김철수", 5).size() != 5
+        || fingerprinter.fingerprints("김철수", 64, 0).size() != 1) {
+        std::cerr << "unexpected fingerprints of a McCune-Reischauer, empty or bounded string\n";
+        return false;
+    }
+    const std::u32string pieces[] = {U"가", U"닭", U"신", U"로", U"이", U"한", U"\u1112\u1161\u11AB", U"\u1100\u116E", U"\u11A8", U"\u1100", U"a", U" ", U"é", U"\U0001F600"};
+    std::mt19937 random(20240111);
+    std::vector<std::uint64_t> fingerprints;
+    for (int i = 0; i < 1000; ++i) {
+        std::u32string w;
+        for (std::size_t length = random() % 12; w.size() < length;)
+            w += pieces[random() % std::size(pieces)];
+        const std::string s = to_utf8(w);
+        fingerprinter.fingerprints(s, 64, 8, fingerprints);
+        std::vector<std::uint64_t> distinct = fingerprints;
+        std::sort(distinct.begin(), distinct.end());
+        if (fingerprints.empty() || fingerprints.front() != korean_romanized_view(s).hash() || fingerprints.size() > 64
+            || std::adjacent_find(distinct.begin(), distinct.end()) != distinct.end()) {
+            std::cerr << s << ": expected up to 64 distinct fingerprints, starting with that of \"" << korean_romanizer::romanize(s) << "\"\n";
+            return false;
+        }
+    }
+    try {
+        fingerprinter.fingerprints("안녕\xEB\x85");
+        std::cerr << "expected std::range_error for fingerprints of invalid UTF-8\n";
+        return false;
+    } catch (const std::range_error&) {
+    }
+    return true;
+}
+
+/**
+ * Checks that the C interface romanizes batches like the C++ interface, into buffers of every size,
+ * and that it reports the sizes the romanizations require and the strings that are not valid UTF-8.
+ */
+bool test_c_interface() {
+    std::mt19937 random(20240110);
+    const char32_t others[] = {U' ', U'a', U'\u00E9', U'\U0001F600', U'\u1100', U'\u1161'};
+    std::string input, expected;
+    std::vector<std::size_t> input_offsets{0}, expected_offsets{0};
+    for (int i = 0; i < 300; ++i) {
+        std::u32string w;
+        for (std::size_t length = random() % 40; w.size() < length;)
+            w += random() % 4 ? static_cast<char32_t>(0xAC00 + random() % 11172) : others[random() % std::size(others)];
+        const std::string s = to_utf8(w);
+        input += s;
+        expected += korean_romanizer::romanize(s);
+        input_offsets.push_back(input.size());
+        expected_offsets.push_back(expected.size());
+    }
+    const std::size_t count = input_offsets.size() - 1;
+    for (const std::size_t capacity : {expected.size() * 2, expected.size(), expected.size() - 1, expected.size() / 2, std::size_t(0)}) {
+        std::string output(capacity, '\0');
+        std::vector<std::size_t> output_offsets(count + 1);
+        const kr_status status = kr_romanize_batch(KR_REVISED_ROMANIZATION, input.data(), input_offsets.data(), count, capacity ? output.data() : nullptr, capacity, output_offsets.data(), nullptr);
+        if (status != (capacity >= expected.size() ? KR_OK : KR_BUFFER_TOO_SMALL) || output_offsets != expected_offsets
+            || (status == KR_OK && output.compare(0, expected.size(), expected) != 0)) {
+            std::cerr << "the C interface romanized a batch into " << capacity << " bytes differently\n";
+            return false;
+        }
+    }
+    char buffer[16];
+    std::size_t size = 0;
+    if (kr_romanize_into(KR_REVISED_ROMANIZATION, "안녕하세요", 15, buffer, 3, &size) != KR_BUFFER_TOO_SMALL || size != 14
+        || kr_romanize_into(KR_MCCUNE_REISCHAUER, "한국어", 9, buffer, sizeof(buffer), &size) != KR_OK || std::string_view(buffer, size) != "han'gugŏ"
+        || kr_romanize_into(KR_REVISED_ROMANIZATION, nullptr, 0, nullptr, 0, &size) != KR_OK || size
+        || kr_romanize_into(static_cast<kr_system>(2), "가", 3, buffer, sizeof(buffer), &size) != KR_INVALID_ARGUMENT
+        || kr_max_romanized_size(KR_REVISED_ROMANIZATION, 100) != korean_romanizer::max_romanized_size(100)) {
+        std::cerr << "unexpected romanization of a single string by the C interface\n";
+        return false;
+    }
+    const std::string invalid = "가나\xEA\xB0다";
+    const std::size_t invalid_offsets[] = {0, 3, 8, 11};
+    std::size_t output_offsets[4], error_index = 0;
+    if (kr_romanize_batch(KR_REVISED_ROMANIZATION, invalid.data(), invalid_offsets, 3, buffer, sizeof(buffer), output_offsets, &error_index) != KR_INVALID_UTF8
+        || error_index != 1 || output_offsets[1] != 2 || output_offsets[3] != 2) {
+        std::cerr << "expected KR_INVALID_UTF8 from the C interface\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Checks what a few calls add to the metrics, including the counts of a thread that has exited,
+ * and that nothing is counted unless the library counts metrics.
+ */
+bool test_metrics() {
+    using metrics = korean_romanizer_metrics;
+    metrics::set_latency_histogram(true);
+    const metrics::snapshot before = metrics::take_snapshot();
+    std::string s;
+    korean_romanizer::romanize("신라 a", s);
+    std::thread([] { korean_romanizer::romanize("가"); }).join();
+    std::string replaced;
+    korean_romanizer::romanize("가\xFF", replaced, korean_romanizer_error_policy::replace);
+    try {
+        korean_romanizer::romanize("가\xFF");
+    } catch (const std::range_error&) {
+    }
+    const metrics::snapshot after = metrics::take_snapshot();
+    metrics::set_latency_histogram(false);
+    std::uint64_t timed_calls = 0;
+    for (std::size_t i = 0; i < metrics::latency_bucket_count; ++i)
+        timed_calls += after.latency_histogram[i] - before.latency_histogram[i];
+    const std::uint64_t scale = metrics::enabled;
+    if (after.calls - before.calls != 4 * scale || after.failed_calls - before.failed_calls != scale || after.input_bytes - before.input_bytes != 19 * scale
+        || after.output_bytes - before.output_bytes != (s.size() + 2 + replaced.size()) * scale || after.hangul_characters - before.hangul_characters != 5 * scale
+        || after.other_code_points - before.other_code_points != 2 * scale || after.invalid_sequences - before.invalid_sequences != scale
+        || after.changed_leading_consonants - before.changed_leading_consonants != scale
+        || after.changed_trailing_consonants - before.changed_trailing_consonants != scale || timed_calls != 4 * scale) {
+        std::cerr << "unexpected metrics of " << after.calls - before.calls << " calls and " << after.hangul_characters - before.hangul_characters << " Hangul characters\n";
+        return false;
+    }
+    return true;
+}
+
+#if __cpp_nontype_template_args >= 201911L
+static_assert(korean_romanizer::romanize_literal<"서울">() == "seoul");
+static_assert(korean_romanizer::romanize_literal<"신문로 (Sinmun-ro)">() == "sinmullo (Sinmun-ro)");
+static_assert(korean_romanizer::romanize_literal<u8"같이">() == "gachi");
+static_assert(korean_romanizer::romanize_literal<"">().empty());
+static_assert(korean_romanizer::romanize_literal<"\u1112\u1161\u11AB\u1100\u116E\u11A8 \u1100\u1161\u11A8">() == "hanguk gak");
+static_assert(basic_romanizer<mccune_reischauer>::romanize_literal<"김치">() == "kimch'i");
+static_assert(basic_romanizer<mccune_reischauer>::romanize_literal<"독립문">() == "tongnimmun");
+
+/**
+ * Checks that romanizing string literals at compile time produces the same romanizations as romanizing them at runtime.
+ */
+bool test_literals() {
+    const std::pair<std::string_view, std::string_view> literals[] = {
+        {"안녕하세요!", korean_romanizer::romanize_literal<"안녕하세요!">()},
+        {"서울특별시 종로구 세종대로 209", korean_romanizer::romanize_literal<"서울특별시 종로구 세종대로 209">()},
+        {"읽기 닭고기 \U0001F600 굳이 좋아요 앉다 핥다 값", korean_romanizer::romanize_literal<"읽기 닭고기 \U0001F600 굳이 좋아요 앉다 핥다 값">()},
+        {"é한국어ㄱ", korean_romanizer::romanize_literal<"é한국어ㄱ">()},
+    };
+    for (const auto& [literal, romanization] : literals) {
+        if (const std::string expected = korean_romanizer::romanize(literal); romanization != expected) {
+            std::cerr << literal << ": expected \"" << expected << "\", got \"" << romanization << "\"\n";
+            return false;
+        }
+    }
+    return true;
+}
+#endif
 
 int main() {
-    std::cout << korean_romanizer::romanize("안녕하세요!");
+    std::cout << korean_romanizer::romanize("안녕하세요!") << '\n';
+    if (!test_every_character_in_every_context() || !test_caller_owned_output() || !test_invalid_utf8() || !test_error_policies() || !test_ascii_runs() || !test_hangul_runs() || !test_stream() || !test_romanized_view() || !test_parallel() || !test_batch() || !test_cache() || !test_offset_map() || !test_decomposed_jamo() || !test_mccune_reischauer() || !test_dictionary() || !test_deromanizer() || !test_fingerprints() || !test_c_interface() || !test_metrics())
+        return 1;
+#if __cpp_nontype_template_args >= 201911L
+    if (!test_literals())
+        return 1;
+#endif
     return 0;
-}
\ No newline at end of file
+}
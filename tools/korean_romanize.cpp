@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "korean_romanizer.h"
+
+/**
+ * @brief Collects output in a large buffer and writes it to a file descriptor in few, large writes.
+ */
+class output_buffer {
+    /**
+     * The size the buffer is written out at.
+     */
+    static constexpr std::size_t flush_size = 1 << 20;
+    /**
+     * The output that has not been written yet.
+     */
+    std::string buffer;
+    /**
+     * The file descriptor the output is written to.
+     */
+    int fd;
+public:
+    explicit output_buffer(const int _fd) : fd(_fd) { buffer.reserve(2 * flush_size); }
+    /**
+     * @return The buffer, which output can be appended to.
+     */
+    std::string& data() { return buffer; }
+    /**
+     * Writes out the buffer up to the given size.
+     */
+    void flush(const std::size_t size) {
+        for (std::size_t written = 0; written < size;) {
+            const ssize_t n = ::write(fd, buffer.data() + written, size - written);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                throw std::runtime_error(std::string("write: ") + std::strerror(errno));
+            written += n;
+        }
+        buffer.erase(0, size);
+    }
+    /**
+     * Writes out the whole buffer.
+     */
+    void flush() { flush(buffer.size()); }
+    /**
+     * Writes out the buffer if it has grown large enough.
+     */
+    void flush_if_full() {
+        if (buffer.size() >= flush_size)
+            flush();
+    }
+};
+
+/**
+ * @brief Options given on the command line.
+ */
+struct options {
+    /**
+     * The byte separating records, after each of which the output is written out, or <code>-1</code> to only write out full buffers.
+     */
+    int delimiter = -1;
+    /**
+     * The amount of threads to romanize memory-mapped files with, or <code>0</code> to use one per hardware thread.
+     */
+    unsigned thread_count = 1;
+    /**
+     * Whether to romanize according to the McCune-Reischauer system instead of the Revised Romanization of Korean.
+     */
+    bool mccune_reischauer = false;
+};
+
+/**
+ * The size of the blocks a memory-mapped file is romanized in.
+ */
+constexpr std::size_t block_size = 64 << 20;
+/**
+ * The size of the chunks read from files that cannot be memory-mapped.
+ */
+constexpr std::size_t chunk_size = 1 << 20;
+/**
+ * How far past its size a block of a memory-mapped file is extended to end after an ASCII byte.
+ */
+constexpr std::size_t max_block_extension = 1 << 20;
+
+/**
+ * Romanizes a memory-mapped file block by block, ending every block after an ASCII byte, which never affects the romanization of its neighbors,
+ * so that the blocks can be romanized on their own. A block with no ASCII byte near its end, such as in a long line of Hangul,
+ * is cut wherever its size runs out and fed to a stream instead, which holds on to the characters at the cut, until a block ends after an ASCII byte again.
+ */
+template <class System>
+void romanize_mapped(const std::string_view file, const options& o, output_buffer& out) {
+    basic_romanizer_stream<System> stream;
+    bool streaming = false;
+    for (std::size_t begin = 0; begin < file.size();) {
+        std::size_t end = std::min(begin + block_size, file.size());
+        const std::size_t extension_end = std::min(end + max_block_extension, file.size());
+        while (end < extension_end && static_cast<unsigned char>(file[end - 1]) >= 0x80)
+            ++end;
+        const bool ends_after_ascii = end == file.size() || static_cast<unsigned char>(file[end - 1]) < 0x80;
+        const std::string_view block = file.substr(begin, end - begin);
+        if (streaming || !ends_after_ascii)
+            stream.feed(block, out.data());
+        else if (o.thread_count == 1)
+            basic_romanizer<System>::romanize(block, out.data());
+        else
+            basic_romanizer<System>::romanize_parallel(block, out.data(), o.thread_count);
+        streaming = !ends_after_ascii;
+        out.flush_if_full();
+        begin = end;
+    }
+    stream.finish(out.data());
+}
+
+/**
+ * Romanizes a file as it is read, writing out every complete record as soon as it has been romanized.
+ */
+template <class System>
+void romanize_streamed(const int fd, const options& o, output_buffer& out) {
+    basic_romanizer_stream<System> stream;
+    std::string chunk(chunk_size, '\0');
+    for (;;) {
+        const ssize_t n = ::read(fd, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw std::runtime_error(std::string("read: ") + std::strerror(errno));
+        if (n == 0)
+            break;
+        stream.feed(std::string_view(chunk.data(), n), out.data());
+        if (o.delimiter < 0) {
+            out.flush_if_full();
+        } else if (const std::size_t last = out.data().rfind(static_cast<char>(o.delimiter)); last != std::string::npos) {
+            // delimiters are ASCII, so everything up to them has been romanized
+            out.flush(last + 1);
+        }
+    }
+    stream.finish(out.data());
+}
+
+/**
+ * Romanizes a file, memory-mapping it if possible. Files are only memory-mapped without a delimiter,
+ * as writing out every record as soon as it is complete needs the output of the streamed path.
+ */
+template <class System>
+void romanize_file(const int fd, const options& o, output_buffer& out) {
+    struct stat status{};
+    if (o.delimiter < 0 && fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        const auto size = static_cast<std::size_t>(status.st_size);
+        if (void* const mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); mapping != MAP_FAILED) {
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            try {
+                romanize_mapped<System>(std::string_view(static_cast<const char*>(mapping), size), o, out);
+            } catch (...) {
+                munmap(mapping, size);
+                throw;
+            }
+            munmap(mapping, size);
+            return;
+        }
+    }
+    romanize_streamed<System>(fd, o, out);
+}
+
+void print_usage(std::ostream& stream) {
+    stream << "Usage: korean-romanize [OPTION]... [FILE]...\n"
+              "Romanize the Hangul in each FILE, or standard input, to standard output.\n"
+              "With no FILE, or when FILE is -, read standard input.\n"
+              "\n"
+              "  -l, --lines        write out the output after every complete line\n"
+              "  -0, --null         write out the output after every complete NUL-terminated record\n"
+              "  -j, --threads=N    romanize large files on N threads (0 for one per hardware thread)\n"
+              "  -s, --system=SYS   romanize according to SYS: rr for the Revised Romanization of Korean (default),\n"
+              "                     mr for McCune-Reischauer\n"
+              "  -h, --help         display this help and exit\n";
+}
+
+int main(const int argc, char** const argv) {
+    options o;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        if (argument == "-l" || argument == "--lines") {
+            o.delimiter = '\n';
+        } else if (argument == "-0" || argument == "--null") {
+            o.delimiter = '\0';
+        } else if (argument == "-j" || argument == "--threads" || argument.rfind("--threads=", 0) == 0) {
+            const char* value = argument[1] == 'j' || argument == "--threads" ? (i + 1 < argc ? argv[++i] : nullptr) : argv[i] + 10;
+            char* value_end = nullptr;
+            const unsigned long thread_count = value ? std::strtoul(value, &value_end, 10) : 0;
+            if (!value || value_end == value || *value_end) {
+                std::cerr << "korean-romanize: invalid thread count\n";
+                return 2;
+            }
+            o.thread_count = static_cast<unsigned>(thread_count);
+        } else if (argument == "-s" || argument == "--system" || argument.rfind("--system=", 0) == 0) {
+            const char* value = argument[1] == 's' || argument == "--system" ? (i + 1 < argc ? argv[++i] : nullptr) : argv[i] + 9;
+            if (!value || (std::string_view(value) != "rr" && std::string_view(value) != "mr")) {
+                std::cerr << "korean-romanize: invalid romanization system\n";
+                return 2;
+            }
+            o.mccune_reischauer = std::string_view(value) == "mr";
+        } else if (argument == "-h" || argument == "--help") {
+            print_usage(std::cout);
+            return 0;
+        } else if (argument.size() > 1 && argument[0] == '-') {
+            std::cerr << "korean-romanize: unknown option '" << argument << "'\n";
+            print_usage(std::cerr);
+            return 2;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty())
+        files.push_back("-");
+    output_buffer out(STDOUT_FILENO);
+    int status = 0;
+    for (const char* file : files) {
+        const bool is_stdin = std::string_view(file) == "-";
+        const int fd = is_stdin ? STDIN_FILENO : open(file, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "korean-romanize: " << file << ": " << std::strerror(errno) << '\n';
+            status = 1;
+            continue;
+        }
+        try {
+            if (o.mccune_reischauer)
+                romanize_file<mccune_reischauer>(fd, o, out);
+            else
+                romanize_file<revised_romanization>(fd, o, out);
+        } catch (const std::range_error&) {
+            std::cerr << "korean-romanize: " << file << ": invalid UTF-8\n";
+            status = 1;
+        } catch (const std::exception& e) {
+            std::cerr << "korean-romanize: " << file << ": " << e.what() << '\n';
+            status = 1;
+        }
+        if (!is_stdin)
+            close(fd);
+    }
+    try {
+        out.flush();
+    } catch (const std::exception& e) {
+        std::cerr << "korean-romanize: " << e.what() << '\n';
+        return 1;
+    }
+    return status;
+}
@@ -0,0 +1,888 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "korean_romanizer.h"
+
+/**
+ * @brief The framing of requests and responses.
+ * @details A request is a 32-bit little-endian length followed by that many bytes of UTF-8.
+ * A response is a 32-bit little-endian length, a status byte and that many bytes of romanization.
+ * Responses on a connection are sent in the order of its requests, so requests can be pipelined.
+ */
+namespace protocol {
+/**
+ * The length that asks for the statistics of the server instead of a romanization, with no bytes following it.
+ */
+constexpr std::uint32_t stats_request = 0xFFFFFFFF;
+/**
+ * The maximum length of a request, beyond which the connection is closed.
+ */
+constexpr std::uint32_t max_request_size = 16 << 20;
+enum status : unsigned char {
+    ok = 0,
+    /**
+     * The request was not valid UTF-8, and the response is empty.
+     */
+    invalid_utf8 = 1,
+    /**
+     * The response holds the statistics of the server as lines of names and values.
+     */
+    stats = 2,
+    /**
+     * The request could not be romanized because of an unexpected error, such as running out of memory, and the response is empty.
+     */
+    internal_error = 3,
+};
+void append_length(std::string& s, const std::uint32_t length) {
+    for (int i = 0; i < 4; ++i)
+        s += static_cast<char>(length >> 8 * i & 0xFF);
+}
+std::uint32_t read_length(const char* const p) {
+    std::uint32_t length = 0;
+    for (int i = 0; i < 4; ++i)
+        length |= static_cast<std::uint32_t>(static_cast<unsigned char>(p[i])) << 8 * i;
+    return length;
+}
+}
+
+/**
+ * @brief Options given on the command line.
+ */
+struct options {
+    std::string socket_path = "korean-romanized.sock";
+    /**
+     * The amount of worker threads, or <code>0</code> to use one per hardware thread.
+     */
+    unsigned thread_count = 0;
+    /**
+     * The maximum amount of requests romanized as one batch.
+     */
+    std::size_t max_batch_size = 256;
+    /**
+     * The amount of requests of a connection whose responses have not been queued for writing yet,
+     * beyond which the server stops reading from the connection until some of them have been.
+     */
+    std::size_t max_requests_in_flight = 1024;
+    /**
+     * The amount of bytes of responses a connection has not accepted yet, beyond which the server stops reading from the connection until it does.
+     */
+    std::size_t max_unsent_bytes = 4 << 20;
+    /**
+     * The amount of bytes of requests of a connection that have been read but not answered yet,
+     * beyond which the server stops reading from the connection until some of them have been.
+     */
+    std::size_t max_queued_bytes = 64 << 20;
+    /**
+     * Whether to romanize according to the McCune-Reischauer system instead of the Revised Romanization of Korean.
+     */
+    bool mccune_reischauer = false;
+    /**
+     * How long to load-test a running server for in seconds, or <code>0</code> to run the server.
+     */
+    double load_test_seconds = 0;
+    /**
+     * The amount of connections the load test opens.
+     */
+    unsigned connections = 16;
+    /**
+     * The amount of requests the load test keeps in flight on every connection.
+     */
+    unsigned pipeline = 8;
+};
+
+using clock_type = std::chrono::steady_clock;
+
+/**
+ * Throws the error of the last failed system call.
+ */
+[[noreturn]] void throw_system_error(const char* const call) {
+    throw std::runtime_error(std::string(call) + ": " + std::strerror(errno));
+}
+
+/**
+ * @brief Requests read from connections in one turn of the event loop, romanized together by a worker.
+ */
+struct batch {
+    struct request {
+        std::uint64_t connection;
+        /**
+         * The position of the request among the requests of its connection.
+         */
+        std::uint64_t sequence;
+        std::string text;
+        clock_type::time_point received;
+    };
+    std::vector<request> requests;
+    /**
+     * The status and romanization of every request, filled in by the worker.
+     */
+    std::vector<std::pair<protocol::status, std::string>> responses;
+};
+
+/**
+ * @brief Hands batches from the event loop to the workers.
+ */
+class work_queue {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::unique_ptr<batch>> batches;
+    bool closed = false;
+public:
+    void push(std::unique_ptr<batch> b) {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(std::move(b));
+        }
+        ready.notify_one();
+    }
+    /**
+     * Waits for the next batch.
+     *
+     * @return The next batch, or <code>nullptr</code> once the queue has been closed.
+     */
+    std::unique_ptr<batch> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !batches.empty(); });
+        if (batches.empty())
+            return nullptr;
+        std::unique_ptr<batch> b = std::move(batches.front());
+        batches.pop_front();
+        return b;
+    }
+    std::size_t size() {
+        const std::lock_guard<std::mutex> lock(mutex);
+        return batches.size();
+    }
+    void close() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+};
+
+/**
+ * @brief Hands romanized batches from the workers back to the event loop, waking it through an eventfd.
+ */
+class completion_queue {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<batch>> batches;
+public:
+    const int fd;
+
+    completion_queue() : fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+        if (fd < 0)
+            throw_system_error("eventfd");
+    }
+    ~completion_queue() { close(fd); }
+    void push(std::unique_ptr<batch> b) {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(std::move(b));
+        }
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const ssize_t n = ::write(fd, &one, sizeof(one));
+    }
+    /**
+     * Takes every batch completed so far, replacing the contents of the given vector.
+     */
+    void take(std::vector<std::unique_ptr<batch>>& result) {
+        std::uint64_t count;
+        [[maybe_unused]] const ssize_t n = ::read(fd, &count, sizeof(count));
+        result.clear();
+        const std::lock_guard<std::mutex> lock(mutex);
+        result.swap(batches);
+    }
+};
+
+/**
+ * Romanizes batches until the work queue is closed, reusing the same buffers for every batch.
+ */
+template <class System>
+void work(work_queue& queue, completion_queue& completions) {
+    basic_romanizer_batch<System> romanizer;
+    std::vector<std::string_view> views;
+    while (std::unique_ptr<batch> b = queue.pop()) {
+        views.clear();
+        for (const batch::request& r : b->requests)
+            views.push_back(r.text);
+        b->responses.resize(views.size());
+        try {
+            romanizer.romanize(views.data(), views.size());
+            for (std::size_t i = 0; i < views.size(); ++i)
+                b->responses[i] = {protocol::ok, std::string(romanizer[i])};
+        } catch (const std::range_error&) {
+            // find the requests that are not valid UTF-8 one by one
+            for (std::size_t i = 0; i < views.size(); ++i) {
+                try {
+                    b->responses[i] = {protocol::ok, basic_romanizer<System>::romanize(views[i])};
+                } catch (const std::range_error&) {
+                    b->responses[i] = {protocol::invalid_utf8, std::string()};
+                } catch (...) {
+                    b->responses[i] = {protocol::internal_error, std::string()};
+                }
+            }
+        } catch (...) {
+            // an unexpected error, such as running out of memory, fails the batch rather than the worker and the whole server
+            for (std::pair<protocol::status, std::string>& response : b->responses)
+                response = {protocol::internal_error, std::string()};
+        }
+        completions.push(std::move(b));
+    }
+}
+
+/**
+ * @brief Keeps the latencies of the most recent requests, from being read to being queued for writing, in microseconds.
+ */
+class latency_recorder {
+    static constexpr std::size_t capacity = 1 << 16;
+    std::vector<std::uint32_t> latencies = std::vector<std::uint32_t>(capacity);
+    std::uint64_t count = 0;
+public:
+    void record(const clock_type::duration latency) {
+        const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        latencies[count++ % capacity] = static_cast<std::uint32_t>(std::min<long long>(microseconds, UINT32_MAX));
+    }
+    /**
+     * Appends the percentiles of the recorded latencies as lines of names and values.
+     */
+    void append_percentiles(std::string& result) const {
+        std::vector<std::uint32_t> sorted(latencies.begin(), latencies.begin() + std::min<std::uint64_t>(count, capacity));
+        std::sort(sorted.begin(), sorted.end());
+        for (const auto& [name, fraction] : {std::pair<const char*, double>{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}, {"max", 1}}) {
+            const std::uint32_t latency = sorted.empty() ? 0 : sorted[std::min(static_cast<std::size_t>(fraction * sorted.size()), sorted.size() - 1)];
+            result += "latency_" + std::string(name) + "_us " + std::to_string(latency) + '\n';
+        }
+    }
+};
+
+/**
+ * @brief Serves romanizations over a Unix domain socket from a single epoll event loop.
+ * @details Requests read in one turn of the loop are grouped into batches, which a fixed pool of workers romanizes,
+ * so no thread is created per request or connection.
+ *
+ * @tparam System The romanization system.
+ */
+template <class System>
+class server {
+    struct connection {
+        int fd;
+        /**
+         * Bytes read but not parsed into requests yet.
+         */
+        std::string input;
+        /**
+         * Bytes of responses not written yet.
+         */
+        std::string output;
+        std::uint64_t next_sequence = 0;
+        std::uint64_t next_sequence_to_send = 0;
+        /**
+         * The bytes of the requests handed to the workers whose responses have not come back yet.
+         */
+        std::size_t queued_bytes = 0;
+        /**
+         * Responses that arrived before the responses to earlier requests.
+         */
+        std::map<std::uint64_t, std::pair<protocol::status, std::string>> ready;
+        /**
+         * The events the connection is watched for.
+         */
+        std::uint32_t events = EPOLLIN | EPOLLRDHUP;
+        bool read_closed = false;
+        /**
+         * Whether parsing stopped because the connection was throttled, so that the rest of @link input @endlink is parsed once it has drained.
+         */
+        bool parsing_stopped = false;
+    };
+    /**
+     * Whether a connection has so many requests or bytes of requests in flight or so many bytes not sent yet that it should not be read from,
+     * so that a client that pipelines faster than it reads cannot make the server buffer without limit.
+     */
+    bool throttled(const connection& c) const {
+        return c.next_sequence - c.next_sequence_to_send >= o.max_requests_in_flight || c.queued_bytes >= o.max_queued_bytes
+            || c.output.size() >= o.max_unsent_bytes;
+    }
+    const options& o;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int signal_fd = -1;
+    std::unordered_map<std::uint64_t, connection> connections;
+    std::uint64_t next_connection = 0;
+    /**
+     * The requests read in the current turn of the event loop.
+     */
+    std::unique_ptr<batch> pending = std::make_unique<batch>();
+    work_queue queue;
+    completion_queue completions;
+    std::vector<std::thread> workers;
+    /**
+     * The batches taken from the completion queue, kept to reuse the vector.
+     */
+    std::vector<std::unique_ptr<batch>> done;
+    latency_recorder latencies;
+    /**
+     * The response to stats requests, built at most once per turn of the event loop since sorting the latencies is costly.
+     */
+    std::string stats_text;
+    bool stats_current = false;
+    /**
+     * The amount of requests handed to the workers whose responses have not come back yet.
+     */
+    std::size_t in_flight = 0;
+    std::uint64_t request_count = 0;
+    std::uint64_t batch_count = 0;
+
+    /**
+     * The tags of epoll events, which are connection ids for every other event.
+     */
+    static constexpr std::uint64_t listen_tag = UINT64_MAX;
+    static constexpr std::uint64_t completion_tag = UINT64_MAX - 1;
+    static constexpr std::uint64_t signal_tag = UINT64_MAX - 2;
+
+    void watch(const int fd, const std::uint32_t events, const std::uint64_t tag, const int operation = EPOLL_CTL_ADD) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = tag;
+        if (epoll_ctl(epoll_fd, operation, fd, &event) < 0)
+            throw_system_error("epoll_ctl");
+    }
+    void accept_connections() {
+        for (;;) {
+            const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    std::cerr << "korean-romanized: accept: " << std::strerror(errno) << '\n';
+                return;
+            }
+            const std::uint64_t id = next_connection++;
+            connections[id].fd = fd;
+            watch(fd, connections[id].events, id);
+        }
+    }
+    void close_connection(const std::uint64_t id) {
+        close(connections[id].fd);
+        connections.erase(id);
+    }
+    const std::string& stats() {
+        if (stats_current)
+            return stats_text;
+        std::string& result = stats_text;
+        result.clear();
+        result += "queue_depth " + std::to_string(in_flight) + '\n';
+        result += "queued_batches " + std::to_string(queue.size()) + '\n';
+        result += "connections " + std::to_string(connections.size()) + '\n';
+        result += "requests " + std::to_string(request_count) + '\n';
+        result += "batches " + std::to_string(batch_count) + '\n';
+        latencies.append_percentiles(result);
+        stats_current = true;
+        return result;
+    }
+    /**
+     * Parses the complete requests read from a connection so far, stopping early once the connection is throttled.
+     * Stats requests count against the limits like any other request until their responses have been written.
+     *
+     * @return Whether every request is well-formed.
+     */
+    bool parse_requests(connection& c, const std::uint64_t id, const clock_type::time_point now) {
+        std::size_t parsed = 0;
+        c.parsing_stopped = false;
+        while (c.input.size() - parsed >= 4) {
+            if (throttled(c)) {
+                c.parsing_stopped = true;
+                break;
+            }
+            const std::uint32_t length = protocol::read_length(c.input.data() + parsed);
+            if (length == protocol::stats_request) {
+                c.ready[c.next_sequence++] = {protocol::stats, stats()};
+                parsed += 4;
+                continue;
+            }
+            if (length > protocol::max_request_size)
+                return false;
+            if (c.input.size() - parsed - 4 < length)
+                break;
+            pending->requests.push_back({id, c.next_sequence++, c.input.substr(parsed + 4, length), now});
+            c.queued_bytes += length;
+            parsed += 4 + length;
+        }
+        c.input.erase(0, parsed);
+        return true;
+    }
+    /**
+     * Reads the available bytes from a connection and parses the complete requests in them,
+     * stopping early once the connection is throttled.
+     *
+     * @return Whether the connection is still open.
+     */
+    bool read_requests(const std::uint64_t id) {
+        connection& c = connections[id];
+        const clock_type::time_point now = clock_type::now();
+        char buffer[1 << 16];
+        while (!throttled(c)) {
+            const ssize_t n = ::read(c.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                c.input.append(buffer, n);
+                if (!parse_requests(c, id, now)) {
+                    close_connection(id);
+                    return false;
+                }
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_connection(id);
+                return false;
+            }
+            c.read_closed = n == 0;
+            break;
+        }
+        return write_responses(id);
+    }
+    /**
+     * Queues the responses that are next in order on a connection and writes as much as the socket accepts,
+     * closing the connection once its peer has stopped sending and every response has been written.
+     * A throttled connection is not watched for reading until it has drained below its limits,
+     * when the requests it had sent but that were not parsed yet are parsed.
+     *
+     * @return Whether the connection is still open.
+     */
+    bool write_responses(const std::uint64_t id) {
+        connection& c = connections[id];
+        for (;;) {
+            for (auto i = c.ready.begin(); i != c.ready.end() && i->first == c.next_sequence_to_send; i = c.ready.erase(i)) {
+                protocol::append_length(c.output, static_cast<std::uint32_t>(i->second.second.size()));
+                c.output += static_cast<char>(i->second.first);
+                c.output += i->second.second;
+                ++c.next_sequence_to_send;
+            }
+            std::size_t written = 0;
+            while (written < c.output.size()) {
+                const ssize_t n = ::send(c.fd, c.output.data() + written, c.output.size() - written, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    break;
+                if (n < 0) {
+                    close_connection(id);
+                    return false;
+                }
+                written += n;
+            }
+            c.output.erase(0, written);
+            if (!c.parsing_stopped || throttled(c))
+                break;
+            if (!parse_requests(c, id, clock_type::now())) {
+                close_connection(id);
+                return false;
+            }
+        }
+        if (c.read_closed && c.output.empty() && c.next_sequence_to_send == c.next_sequence) {
+            close_connection(id);
+            return false;
+        }
+        if (const std::uint32_t events = (c.read_closed || throttled(c) ? 0u : EPOLLIN | EPOLLRDHUP) | (c.output.empty() ? 0u : EPOLLOUT); events != c.events) {
+            c.events = events;
+            watch(c.fd, events, id, EPOLL_CTL_MOD);
+        }
+        return true;
+    }
+    /**
+     * Hands the requests read in this turn of the event loop to the workers, split into batches of at most the maximum size.
+     */
+    void dispatch() {
+        while (!pending->requests.empty()) {
+            auto b = std::make_unique<batch>();
+            if (pending->requests.size() <= o.max_batch_size) {
+                b.swap(pending);
+            } else {
+                const auto split = pending->requests.end() - o.max_batch_size;
+                b->requests.assign(std::make_move_iterator(split), std::make_move_iterator(pending->requests.end()));
+                pending->requests.erase(split, pending->requests.end());
+            }
+            in_flight += b->requests.size();
+            request_count += b->requests.size();
+            ++batch_count;
+            queue.push(std::move(b));
+        }
+    }
+    void complete() {
+        completions.take(done);
+        const clock_type::time_point now = clock_type::now();
+        std::vector<std::uint64_t> touched;
+        for (const std::unique_ptr<batch>& b : done) {
+            in_flight -= b->requests.size();
+            for (std::size_t i = 0; i < b->requests.size(); ++i) {
+                const batch::request& r = b->requests[i];
+                latencies.record(now - r.received);
+                // the connection might have been closed in the meantime
+                if (const auto c = connections.find(r.connection); c != connections.end()) {
+                    c->second.queued_bytes -= r.text.size();
+                    c->second.ready[r.sequence] = std::move(b->responses[i]);
+                    touched.push_back(r.connection);
+                }
+            }
+        }
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        for (const std::uint64_t id : touched) {
+            if (connections.count(id))
+                write_responses(id);
+        }
+    }
+public:
+    explicit server(const options& _o) : o(_o) {}
+    ~server() {
+        queue.close();
+        for (std::thread& worker : workers)
+            worker.join();
+        for (auto& [id, c] : connections)
+            close(c.fd);
+        for (const int fd : {listen_fd, epoll_fd, signal_fd}) {
+            if (fd >= 0)
+                close(fd);
+        }
+        if (listen_fd >= 0)
+            unlink(o.socket_path.c_str());
+    }
+    /**
+     * Serves requests until the process receives SIGINT or SIGTERM.
+     */
+    void run() {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (o.socket_path.size() >= sizeof(address.sun_path))
+            throw std::runtime_error("socket path too long");
+        std::memcpy(address.sun_path, o.socket_path.c_str(), o.socket_path.size() + 1);
+        listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0)
+            throw_system_error("socket");
+        unlink(o.socket_path.c_str());
+        if (bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+            throw_system_error("bind");
+        if (listen(listen_fd, SOMAXCONN) < 0)
+            throw_system_error("listen");
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (signal_fd < 0 || epoll_fd < 0)
+            throw_system_error(signal_fd < 0 ? "signalfd" : "epoll_create1");
+        watch(listen_fd, EPOLLIN, listen_tag);
+        watch(completions.fd, EPOLLIN, completion_tag);
+        watch(signal_fd, EPOLLIN, signal_tag);
+        // the workers inherit the blocked signals, so only the event loop sees them
+        const unsigned thread_count = o.thread_count ? o.thread_count : std::max(std::thread::hardware_concurrency(), 1u);
+        for (unsigned i = 0; i < thread_count; ++i)
+            workers.emplace_back(work<System>, std::ref(queue), std::ref(completions));
+        std::cerr << "korean-romanized: listening on " << o.socket_path << " with " << thread_count << " workers\n";
+        epoll_event events[256];
+        for (;;) {
+            const int count = epoll_wait(epoll_fd, events, static_cast<int>(std::size(events)), -1);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count < 0)
+                throw_system_error("epoll_wait");
+            stats_current = false;
+            for (int i = 0; i < count; ++i) {
+                const std::uint64_t tag = events[i].data.u64;
+                if (tag == signal_tag)
+                    return;
+                if (tag == listen_tag) {
+                    accept_connections();
+                } else if (tag == completion_tag) {
+                    complete();
+                } else if (connections.count(tag)) {
+                    // a peer that has hung up completely cannot read its responses anymore, and epoll keeps reporting it
+                    // even while the connection is throttled and not watched for reading
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                        close_connection(tag);
+                        continue;
+                    }
+                    if (events[i].events & (EPOLLIN | EPOLLRDHUP) && !connections[tag].read_closed && !read_requests(tag))
+                        continue;
+                    if (events[i].events & EPOLLOUT)
+                        write_responses(tag);
+                }
+            }
+            dispatch();
+        }
+    }
+};
+
+/**
+ * Opens a connection to the server.
+ */
+int connect_to(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("socket path too long");
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        throw_system_error("socket");
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        throw_system_error("connect");
+    }
+    return fd;
+}
+void write_all(const int fd, const std::string& s) {
+    for (std::size_t written = 0; written < s.size();) {
+        const ssize_t n = ::send(fd, s.data() + written, s.size() - written, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw_system_error("send");
+        written += n;
+    }
+}
+void read_all(const int fd, char* const data, const std::size_t size) {
+    for (std::size_t read = 0; read < size;) {
+        const ssize_t n = ::read(fd, data + read, size - read);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw std::runtime_error("connection closed by the server");
+        read += n;
+    }
+}
+/**
+ * Reads a response, returning its status.
+ */
+protocol::status read_response(const int fd, std::string& text) {
+    char header[5];
+    read_all(fd, header, sizeof(header));
+    text.resize(protocol::read_length(header));
+    read_all(fd, text.data(), text.size());
+    return static_cast<protocol::status>(header[4]);
+}
+
+/**
+ * Sends names to a running server over many connections, keeping several requests in flight on each,
+ * and prints the throughput and latencies seen by the clients followed by the statistics of the server.
+ */
+int load_test(const options& o) {
+    const std::string_view names[] = {"김민준", "이서연", "박지훈", "서울특별시 종로구", "신문로", "안녕하세요!", "같이 갈래?", "한국어 \U0001F600"};
+    std::string requests[std::size(names)];
+    for (std::size_t i = 0; i < std::size(names); ++i) {
+        protocol::append_length(requests[i], static_cast<std::uint32_t>(names[i].size()));
+        requests[i] += names[i];
+    }
+    std::vector<std::vector<std::uint32_t>> latencies(o.connections);
+    std::vector<std::string> errors(o.connections);
+    const clock_type::time_point deadline = clock_type::now() + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(o.load_test_seconds));
+    std::vector<std::thread> clients;
+    for (unsigned i = 0; i < o.connections; ++i) {
+        clients.emplace_back([&, i] {
+            try {
+                const int fd = connect_to(o.socket_path);
+                std::deque<clock_type::time_point> sent;
+                std::string response;
+                std::size_t next = i;
+                for (;;) {
+                    const bool more = clock_type::now() < deadline;
+                    while (more && sent.size() < o.pipeline) {
+                        write_all(fd, requests[next++ % std::size(requests)]);
+                        sent.push_back(clock_type::now());
+                    }
+                    if (sent.empty())
+                        break;
+                    if (read_response(fd, response) != protocol::ok)
+                        throw std::runtime_error("unexpected response status");
+                    latencies[i].push_back(static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - sent.front()).count()));
+                    sent.pop_front();
+                }
+                close(fd);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        });
+    }
+    const clock_type::time_point start = clock_type::now();
+    for (std::thread& client : clients)
+        client.join();
+    const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    for (const std::string& error : errors) {
+        if (!error.empty()) {
+            std::cerr << "korean-romanized: " << error << '\n';
+            return 1;
+        }
+    }
+    std::vector<std::uint32_t> all;
+    for (const std::vector<std::uint32_t>& l : latencies)
+        all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    std::cout << "requests " << all.size() << "\nrequests_per_second " << static_cast<std::uint64_t>(all.size() / seconds) << '\n';
+    for (const auto& [name, fraction] : {std::pair<const char*, double>{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}, {"max", 1}})
+        std::cout << "client_latency_" << name << "_us " << (all.empty() ? 0 : all[std::min(static_cast<std::size_t>(fraction * all.size()), all.size() - 1)]) << '\n';
+    const int fd = connect_to(o.socket_path);
+    std::string stats;
+    protocol::append_length(stats, protocol::stats_request);
+    write_all(fd, stats);
+    read_response(fd, stats);
+    close(fd);
+    std::cout << stats;
+    return 0;
+}
+
+void print_usage(std::ostream& stream) {
+    stream << "Usage: korean-romanized [OPTION]...\n"
+              "Serve romanizations over a Unix domain socket, or load-test a running server.\n"
+              "\n"
+              "A request is a 32-bit little-endian length followed by that many bytes of UTF-8, or the length 0xFFFFFFFF\n"
+              "alone to ask for statistics. A response is a 32-bit little-endian length, a status byte (0 for a romanization,\n"
+              "1 for invalid UTF-8, 2 for statistics, 3 for an unexpected error) and that many bytes. Responses come in the order\n"
+              "of the requests.\n"
+              "\n"
+              "  -S, --socket=PATH   listen on or connect to PATH (default korean-romanized.sock)\n"
+              "  -j, --threads=N     romanize on N worker threads (default 0, one per hardware thread)\n"
+              "  -b, --batch=N       romanize at most N requests as one batch (default 256)\n"
+              "      --max-in-flight=N    stop reading from a connection with N requests not answered yet (default 1024)\n"
+              "      --max-queued=BYTES   stop reading from a connection with BYTES of requests not answered yet (default 67108864)\n"
+              "      --max-unsent=BYTES   stop reading from a connection with BYTES of responses not sent yet (default 4194304)\n"
+              "  -s, --system=SYS    romanize according to SYS: rr for the Revised Romanization of Korean (default),\n"
+              "                      mr for McCune-Reischauer\n"
+              "      --load-test=SECONDS  send requests to a running server for SECONDS and print the latencies\n"
+              "      --connections=N      open N connections when load-testing (default 16)\n"
+              "      --pipeline=N         keep N requests in flight on every connection when load-testing (default 8)\n"
+              "  -h, --help          display this help and exit\n";
+}
+
+int main(const int argc, char** const argv) {
+    options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        // the value of an option, given either after an equals sign or as the next argument
+        const auto value = [&](const std::string_view short_name, const std::string_view long_name) -> const char* {
+            if ((!short_name.empty() && argument == short_name) || argument == long_name)
+                return i + 1 < argc ? argv[++i] : nullptr;
+            return argv[i] + long_name.size() + 1;
+        };
+        const auto is = [&argument](const std::string_view short_name, const std::string_view long_name) {
+            return (!short_name.empty() && argument == short_name) || argument == long_name || (argument.size() > long_name.size() && argument.rfind(long_name, 0) == 0 && argument[long_name.size()] == '=');
+        };
+        const auto number = [](const char* const v, unsigned long& result) {
+            char* end = nullptr;
+            result = v ? std::strtoul(v, &end, 10) : 0;
+            return v && end != v && !*end;
+        };
+        unsigned long n;
+        if (is("-S", "--socket")) {
+            const char* const v = value("-S", "--socket");
+            if (!v || !*v) {
+                std::cerr << "korean-romanized: invalid socket path\n";
+                return 2;
+            }
+            o.socket_path = v;
+        } else if (is("-j", "--threads")) {
+            if (!number(value("-j", "--threads"), n)) {
+                std::cerr << "korean-romanized: invalid thread count\n";
+                return 2;
+            }
+            o.thread_count = static_cast<unsigned>(n);
+        } else if (is("-b", "--batch")) {
+            if (!number(value("-b", "--batch"), n) || !n) {
+                std::cerr << "korean-romanized: invalid batch size\n";
+                return 2;
+            }
+            o.max_batch_size = n;
+        } else if (is("", "--max-in-flight")) {
+            if (!number(value("", "--max-in-flight"), n) || !n) {
+                std::cerr << "korean-romanized: invalid request limit\n";
+                return 2;
+            }
+            o.max_requests_in_flight = n;
+        } else if (is("", "--max-queued")) {
+            if (!number(value("", "--max-queued"), n) || !n) {
+                std::cerr << "korean-romanized: invalid request byte limit\n";
+                return 2;
+            }
+            o.max_queued_bytes = n;
+        } else if (is("", "--max-unsent")) {
+            if (!number(value("", "--max-unsent"), n) || !n) {
+                std::cerr << "korean-romanized: invalid output limit\n";
+                return 2;
+            }
+            o.max_unsent_bytes = n;
+        } else if (is("-s", "--system")) {
+            const char* const v = value("-s", "--system");
+            if (!v || (std::string_view(v) != "rr" && std::string_view(v) != "mr")) {
+                std::cerr << "korean-romanized: invalid romanization system\n";
+                return 2;
+            }
+            o.mccune_reischauer = std::string_view(v) == "mr";
+        } else if (is("", "--load-test")) {
+            const char* const v = value("", "--load-test");
+            char* end = nullptr;
+            o.load_test_seconds = v ? std::strtod(v, &end) : 0;
+            if (!v || end == v || *end || !(o.load_test_seconds > 0)) {
+                std::cerr << "korean-romanized: invalid load test duration\n";
+                return 2;
+            }
+        } else if (is("", "--connections")) {
+            if (!number(value("", "--connections"), n) || !n) {
+                std::cerr << "korean-romanized: invalid connection count\n";
+                return 2;
+            }
+            o.connections = static_cast<unsigned>(n);
+        } else if (is("", "--pipeline")) {
+            if (!number(value("", "--pipeline"), n) || !n) {
+                std::cerr << "korean-romanized: invalid pipeline depth\n";
+                return 2;
+            }
+            o.pipeline = static_cast<unsigned>(n);
+        } else if (argument == "-h" || argument == "--help") {
+            print_usage(std::cout);
+            return 0;
+        } else {
+            std::cerr << "korean-romanized: unknown option '" << argument << "'\n";
+            print_usage(std::cerr);
+            return 2;
+        }
+    }
+    try {
+        if (o.load_test_seconds > 0)
+            return load_test(o);
+        if (o.mccune_reischauer)
+            server<mccune_reischauer>(o).run();
+        else
+            server<revised_romanization>(o).run();
+    } catch (const std::exception& e) {
+        std::cerr << "korean-romanized: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}